@@ -2,6 +2,8 @@
 #include "DSParseJob.h"
 #include "Highlighting.h"
 #include "DSSessionSettings.h"
+#include "DSProjectFiles.h"
+#include "duchain/ImportPackageLanguage.h"
 #include "codecompletion/DSCodeCompletionModel.h"
 #include "configpage/ProjectConfigPage.h"
 #include "configpage/SessionConfigPage.h"
@@ -29,13 +31,17 @@ K_PLUGIN_FACTORY_WITH_JSON( KDevDragonScriptSupportFactory,
 
 DSLanguageSupport::DSLanguageSupport(QObject *parent, const QVariantList& args) :
 IPlugin(QStringLiteral("dragonscriptlanguagesupport"), parent),
-pHighlighting( new Highlighting( this ) )
+pHighlighting( new Highlighting( this ) ),
+pProjectFiles( new DSProjectFiles( this ) )
 {
 	Q_UNUSED(args);
 	pSelf = this;
 	
 	DSSessionSettings::self.update();
 	
+	// reuse stored language files DUChain if the installed snapshot did not change
+	ImportPackageLanguage::language().loadSnapshot();
+	
 	DSCodeCompletionModel * const codeCompletion = new DSCodeCompletionModel( this );
 	new CodeCompletion( this, codeCompletion, "DragonScript" );
 	
@@ -47,6 +53,9 @@ DSLanguageSupport::~DSLanguageSupport(){
 	// By locking the parse-mutexes, we make sure that parse jobs get a chance to finish in a good state
 	parseLock()->unlock();
 	
+	// sessions own ASTs and memory pools. release them while the plugin is still loaded
+	pParseSessionCache.clear();
+	
 	delete pHighlighting;
 	pHighlighting = nullptr;
 	
@@ -9,6 +9,7 @@
 #include <language/duchain/topducontext.h>
 
 #include "duchain/ImportPackages.h"
+#include "parser/ParseSessionCache.h"
 
 
 using namespace KDevelop;
@@ -16,6 +17,7 @@ using namespace KDevelop;
 namespace DragonScript {
 
 class Highlighting;
+class DSProjectFiles;
 
 /**
  * Language support module for DragonScript language.
@@ -29,6 +31,8 @@ private:
 	static DSLanguageSupport *pSelf;
 	
 	ImportPackages pImportPackages;
+	DSProjectFiles *pProjectFiles;
+	ParseSessionCache pParseSessionCache;
 	
 	
 	
@@ -68,6 +72,12 @@ public:
 	
 	/** Import packages. */
 	inline ImportPackages &importPackages(){ return pImportPackages; }
+	
+	/** Script files of open projects. */
+	inline DSProjectFiles &projectFiles() const{ return *pProjectFiles; }
+	
+	/** Parse sessions shared by the parse jobs of the different phases. */
+	inline ParseSessionCache &parseSessionCache(){ return pParseSessionCache; }
 };
 
 }
@@ -25,8 +25,11 @@
 
 #include "DSParseJob.h"
 #include "ParseSession.h"
+#include "ParseSessionCache.h"
+#include "FunctionBodyCache.h"
 #include "DSLanguageSupport.h"
 #include "DSSessionSettings.h"
+#include "DSProjectFiles.h"
 #include "dsp_debugvisitor.h"
 #include "DeclarationBuilder.h"
 #include "EditorIntegrator.h"
@@ -37,6 +40,11 @@
 #include "ImportPackageDragengine.h"
 #include "ImportPackageDirectory.h"
 #include "DelayedParsing.h"
+#include "TypeCache.h"
+#include "ClassIndex.h"
+#include "MemberTableCache.h"
+#include "CastableCache.h"
+#include "NamespaceIndex.h"
 
 
 using namespace KDevelop;
@@ -48,7 +56,8 @@ static const IndexedString languageString( "DragonScript" );
 DSParseJob::DSParseJob( const IndexedString &url, ILanguageSupport *languageSupport ) :
 ParseJob( url, languageSupport ),
 pParentJob( nullptr ),
-pStartAst( nullptr )
+pStartAst( nullptr ),
+pWaitForPhase( 0 )
 {
 // 	DelayedParsing::self().setDebugEnabled( true );
 	
@@ -57,12 +66,8 @@ pStartAst( nullptr )
 	if( project ){
 		pProjectSettings.load( *project );
 		
-		const QSet<IndexedString> files( project->fileSet() );
-		foreach( const IndexedString &file, files ){
-			if( file.str().endsWith( ".ds" ) ){
-				pProjectFiles << file;
-			}
-		}
+		// the project phase barrier tracks the script files of the project
+		pPhaseBarrier = DSLanguageSupport::self()->projectFiles().phaseBarrier( project );
 	}
 }
 
@@ -84,6 +89,11 @@ void DSParseJob::run( ThreadWeaver::JobPointer self, ThreadWeaver::Thread *threa
 	if( checkAbort() || ! prepare() ){
 		return;
 	}
+	
+	// dragonscript works a bit different than other languages. script files always
+	// belong to a namespace and all files in the namespace are visible without
+	// needing an import statement
+	findPackage();
 // 	qDebug() << "DSParseJob.run: start phase" << pPhase << "for" << document();
 	
 	// features set if user forces a reload of the file:
@@ -117,20 +127,44 @@ void DSParseJob::run( ThreadWeaver::JobPointer self, ThreadWeaver::Thread *threa
 // 		return 1;
 // 	}
 	
-	// parse document
-	ParseSession session( document(), contents().contents );
+	// parse document. the session is shared across all phases as long as the content
+	// does not change. parse() returns the stored result if already parsed
+	const ParseSession::Ref sessionRef( DSLanguageSupport::self()->parseSessionCache().session(
+		document(), contents().modification, contents().contents ) );
+	ParseSession &session = *sessionRef;
 	//session.setDebug( true );
 	
+	// it looks like tracker is present only if the file is open in the editor.
+	// calling trackerForUrl() is stated to be thread safe but not accessing
+	// the returned object
+	const bool openInEditor = ICore::self()->languageController()->
+		backgroundParser()->trackerForUrl( document() );
+	
+	// package files not open in the editor never build uses. skim them skipping function
+	// bodies. project files are parsed fully since one parse result serves all phases
+	const bool skim = pPackage && ! openInEditor;
+	
 	pStartAst = nullptr;
-	if( session.parse( &pStartAst ) ){
+	const bool parsed = session.parse( &pStartAst, skim );
+	DSLanguageSupport::self()->parseSessionCache().updateMemorySize( document() );
+	
+	if( parsed ){
 		if( checkAbort() ){
 			return;
 		}
 		
-		// dragonscript works a bit different than other languages. script files always
-		// belong to a namespace and all files in the namespace are visible without
-		// needing an import statement
-		findPackage();
+		// edits inside a single function body rebuild only this function. declarations
+		// outside the function do not change so other files need no new phase either
+		QVector<FunctionBodyCache::Body> bodies;
+		int editedFunction = -1;
+		if( openInEditor ){
+			bodies = FunctionBodyCache::collect( session, pStartAst );
+			editedFunction = findEditedFunction( session, bodies );
+			if( editedFunction != -1 ){
+				pPhase = 3;
+			}
+		}
+		
 		findDependencies();
 		
 		// verify all files in the package or project are on the same phase or higher
@@ -143,18 +177,26 @@ void DSParseJob::run( ThreadWeaver::JobPointer self, ThreadWeaver::Thread *threa
 // 		qDebug() << "DSParseJob.run: dependencies ready for" << document();
 		EditorIntegrator editor( session );
 		
-// 		qDebug() << "DSParseJob.run: build declaration phase" << pPhase << "features" << minimumFeatures() << "for" << document();
-		if( ! buildDeclaration( editor ) ){
-			abortJob();
-			reparseLater( pPhase );
-			return;
-		}
-		if( checkAbort() ){
-			return;
-		}
-		
-		if( pPhase > 2 ){
-			if( ! buildUses( editor ) ){
+		if( editedFunction != -1 ){
+			if( ! buildEditedFunction( editor, bodies.at( editedFunction ) ) ){
+				// function could not be rebuilt in place. run all phases again
+				FunctionBodyCache::self().remove( document() );
+				abortJob();
+				reparseLater( 1 );
+				return;
+			}
+			if( checkAbort() ){
+				return;
+			}
+			
+			requestLazyFiles();
+			
+		}else{
+			// function bodies are stored again once all phases finished
+			FunctionBodyCache::self().remove( document() );
+			
+// 			qDebug() << "DSParseJob.run: build declaration phase" << pPhase << "features" << minimumFeatures() << "for" << document();
+			if( ! buildDeclaration( editor ) ){
 				abortJob();
 				reparseLater( pPhase );
 				return;
@@ -162,6 +204,19 @@ void DSParseJob::run( ThreadWeaver::JobPointer self, ThreadWeaver::Thread *threa
 			if( checkAbort() ){
 				return;
 			}
+			
+			if( pPhase > 2 ){
+				if( ! buildUses( editor ) ){
+					abortJob();
+					reparseLater( pPhase );
+					return;
+				}
+				if( checkAbort() ){
+					return;
+				}
+				
+				requestLazyFiles();
+			}
 		}
 		
 		highlightDUChain();
@@ -181,22 +236,29 @@ void DSParseJob::run( ThreadWeaver::JobPointer self, ThreadWeaver::Thread *threa
 			// reschedule only if this is a project file. building uses for package files
 			// is not needed since it is not used but expensive to do
 			// 
-			// it looks like tracker is present only if the file is open in the editor.
-			// calling trackerForUrl() is stated to be thread safe but not accessing
-			// the returned object
-			// 
 			// if the file is open in the editor keep updating otherwise not
-			const bool openInEditor = ICore::self()->languageController()->
-				backgroundParser()->trackerForUrl( document() );
-			
 			if( ! pPackage || openInEditor ){
 				if( openInEditor ){
 					reparseLater( pPhase + 1 );
 				}
+				
+			}else if( pPhase > 1 || pPackage->lazy() ){
+				// package files not open in the editor stop at phase 2. files of lazy
+				// packages stop at phase 1 unless requested by dependent files
+				DSLanguageSupport::self()->parseSessionCache().remove( document() );
+			}
+			
+		}else{
+			DSLanguageSupport::self()->parseSessionCache().remove( document() );
+			
+			if( openInEditor ){
+				storeFunctionBodies( session, bodies );
 			}
 		}
 		
 	}else{
+		DSLanguageSupport::self()->parseSessionCache().remove( document() );
+		FunctionBodyCache::self().remove( document() );
 		parseFailed();
 	}
 	
@@ -215,6 +277,15 @@ void DSParseJob::run( ThreadWeaver::JobPointer self, ThreadWeaver::Thread *threa
 	
 	finishTopContext();
 	
+	if( pPhaseBarrier ){
+		pPhaseBarrier->cancelWaiting( document() );
+		pPhaseBarrier->fileFinished( document(), pPhase );
+	}
+	
+	if( pPhase == 3 && pPackage && pPackage->name() == ImportPackageLanguage::packageName ){
+		ImportPackageLanguage::language().storeSnapshotIfComplete();
+	}
+	
 	DelayedParsing::self().parsingFinished( document() );
 	
 	DUChain::self()->emitUpdateReady( document(), duChain() );
@@ -270,6 +341,23 @@ bool DSParseJob::verifyUpdateRequired(){
 		return false;
 	}
 	
+	// language files are not reparsed as long as the stored snapshot is valid and the
+	// file still matches the stored revision
+	ImportPackageLanguage &language = ImportPackageLanguage::language();
+	if( language.snapshotValid() && language.files().contains( document() ) ){
+		DUChainReadLocker lock;
+		TopDUContext * const context = DUChain::self()->chainForDocument( document() );
+		if( context && phaseFromFlags( context->features() ) == 3
+		&& context->parsingEnvironmentFile() && ! context->parsingEnvironmentFile()->needsUpdate() ){
+			setDuChain( context );
+			if( ICore::self()->languageController()->backgroundParser()->trackerForUrl( document() ) ){
+				lock.unlock();
+				highlightDUChain();
+			}
+			return true;
+		}
+	}
+	
 	{
 	const UrlParseLock parseLock( document() );
 	if( isUpdateRequired( languageString ) ){
@@ -318,6 +406,10 @@ void DSParseJob::findPackage(){
 	// this file is parsed as a dependency of some other file. if the package can not
 	// be found then this is a project file to be parsed
 	pPackage = DSLanguageSupport::self()->importPackages().packageContaining( document() );
+	
+	if( pPackage ){
+		pPhaseBarrier = pPackage->phaseBarrier();
+	}
 }
 
 void DSParseJob::findDependencies(){
@@ -353,87 +445,98 @@ bool DSParseJob::allFilesRequiredPhase(){
 	// verify all other files in the same package or project have phase which is are least
 	// one less than the parsing phase. hence all other files finished the previouis phase.
 	// this check is not done for phase 1 since this is the first phase
+	pWaitForPhase = 0;
+	
 	if( pPhase < 2 ){
 		return true;
 	}
 	
 	DUChainReadLocker lock;
-	QSet<IndexedString> files;
+	BackgroundParser &bp = *ICore::self()->languageController()->backgroundParser();
+	DUChain &duchain = *DUChain::self();
+	// files in lazy packages are only skimmed unless referenced. requiring them to
+	// finish the previous phase would fully parse the entire package
+	const int minPhase = pPackage && pPackage->lazy() ? 1 : pPhase - 1;
 	
-	if( pPackage ){
-		files.unite( pPackage->files() );
-		
-	}else{
-		files.unite( pProjectFiles );
+	pTypeFinder.addSearchContext( duchain.chainForDocument( document() ) );
+	
+	if( ! pPhaseBarrier ){
+		return true;
 	}
 	
-	BackgroundParser &bp = *ICore::self()->languageController()->backgroundParser();
-	DUChain &duchain = *DUChain::self();
-	const int minPhase = pPhase - 1;
+	// the barrier knows the phase files finished. only files below the required phase
+	// have to be examined. loaded contexts can be ahead of the barrier if they have been
+	// parsed before the barrier knew about them. update the barrier in this case
+	QSet<IndexedString> missing;
 	bool allPassed = true;
 	
-	pTypeFinder.searchContexts() << duchain.chainForDocument( document() );
-	
-	foreach( const IndexedString &file, files ){
-		if( file == document() ){
-			continue;
-		}
-		
-		TopDUContext * const context = duchain.chainForDocument( file );
-		if( ! context ){
-			// file has no context. we do not know yet what phase it has
-// 			qDebug() << "DSParseJob.run: no context for" << file << "for" << document();
+	if( ! pPhaseBarrier->reached( minPhase, document(), &missing ) ){
+		foreach( const IndexedString &file, missing ){
+			TopDUContext * const context = duchain.chainForDocument( file );
+			const int phase = context ? phaseFromFlags( context->features() ) : 0;
 			
-			if( bp.isQueued( file ) ){
-				pReparsePriority = qMax( pReparsePriority, bp.priorityForDocument( file ) );
-				
-			}else if( ! DelayedParsing::self().isWaiting( file ) ){
-				const int features = TopDUContext::VisibleDeclarationsAndContexts
-					| DSParseJob::Resheduled
-					| DSParseJob::phaseFlags( 1 );
-				
-				ICore::self()->languageController()->backgroundParser()->addDocument( file,
-					static_cast<TopDUContext::Features>( features ), 0, nullptr,
-					ParseJob::IgnoresSequentialProcessing, 10 );
+			if( phase >= minPhase ){
+				pPhaseBarrier->fileFinished( file, phase );
+				continue;
 			}
-			pWaitForFiles << file;
-			allPassed = false;
-			continue;
-			//return false;
-		}
-		
-		const int phase = phaseFromFlags( context->features() );
-		if( phase < minPhase ){
-			// context not at the required phase yet
-// 			qDebug() << "DSParseJob.run: phase" << phase << "file" << file << "too low" << pPhase << "for" << document();
 			
 			if( bp.isQueued( file ) ){
 				pReparsePriority = qMax( pReparsePriority, bp.priorityForDocument( file ) );
 				
-			}else if( ! DelayedParsing::self().isWaiting( file ) ){
+			}else if( ! DelayedParsing::self().isWaiting( file ) && ! pPhaseBarrier->isWaiting( file ) ){
 				// not in the right state and neither pending to be parsed nor waiting for
 				// other files. kick the job in the buts to get running again
-				const int features = context->features()
-					| TopDUContext::VisibleDeclarationsAndContexts
-					| DSParseJob::Resheduled
-					| DSParseJob::phaseFlags( phase + 1 );
-				
-				ICore::self()->languageController()->backgroundParser()->addDocument( file,
-					static_cast<TopDUContext::Features>( features ), 0, nullptr,
-					ParseJob::IgnoresSequentialProcessing, 10 );
+				scheduleFileForPhase( file, context, phase + 1 );
 			}
-			pWaitForFiles << file;
 			allPassed = false;
+		}
+		
+		if( ! allPassed ){
+			pWaitForPhase = minPhase;
+			return false;
+		}
+	}
+	
+	const QSet<IndexedString> files( pPhaseBarrier->files() );
+	foreach( const IndexedString &file, files ){
+		if( file == document() ){
 			continue;
-			//return false;
 		}
 		
-		pTypeFinder.searchContexts() << context;
+		TopDUContext * const context = duchain.chainForDocument( file );
+		if( context ){
+			pTypeFinder.addSearchContext( context );
+			continue;
+		}
+		
+		// context has been unloaded. the phase is unknown again
+		pPhaseBarrier->fileFinished( file, 0 );
+		if( ! bp.isQueued( file ) ){
+			scheduleFileForPhase( file, nullptr, 1 );
+		}
+		allPassed = false;
 	}
 	
+	if( ! allPassed ){
+		pWaitForPhase = minPhase;
+	}
 	return allPassed;
 }
 
+void DSParseJob::scheduleFileForPhase( const IndexedString &file, TopDUContext *context, int phase ){
+	int features = TopDUContext::VisibleDeclarationsAndContexts
+		| DSParseJob::Resheduled
+		| DSParseJob::phaseFlags( phase );
+	
+	if( context ){
+		features |= context->features();
+	}
+	
+	ICore::self()->languageController()->backgroundParser()->addDocument( file,
+		static_cast<TopDUContext::Features>( features ), 0, nullptr,
+		ParseJob::IgnoresSequentialProcessing, 10 );
+}
+
 void DSParseJob::reparseLater( int phase ){
 	const int features = minimumFeatures()
 		| TopDUContext::VisibleDeclarationsAndContexts
@@ -507,13 +610,34 @@ void DSParseJob::reparseLater( int phase ){
 // 	qDebug() << "DSParseJob.reparseLater: phase" << phase << "priority" << priority << "for" << document();
 	
 	if( pWaitForFiles.isEmpty() ){
+		// waiting for other files to finish the previous phase is done using the phase
+		// barrier. this schedules the document once when the last file finished
+		if( pWaitForPhase > 0 && pPhaseBarrier && pPhaseBarrier->waitFor( document(), pWaitForPhase,
+		DelayedParsing::ScheduleParameters{
+			.remainingFileCount = 0,
+			.features = static_cast<TopDUContext::Features>( features ),
+			.priority = priority,
+			.flags = IgnoresSequentialProcessing,
+			.delay = 10,
+			.dependencyDepth = dependencyDepth()
+		} ) ){
+			return;
+		}
+		
 		ICore::self()->languageController()->backgroundParser()->addDocument( document(),
 			static_cast<TopDUContext::Features>( features ), priority, nullptr,
 			IgnoresSequentialProcessing, 10 );
 		
 	}else{
 		DelayedParsing::self().waitFor( document(), pWaitForFiles,
-			static_cast<TopDUContext::Features>( features ), priority );
+			DelayedParsing::ScheduleParameters{
+				.remainingFileCount = 0,
+				.features = static_cast<TopDUContext::Features>( features ),
+				.priority = priority,
+				.flags = IgnoresSequentialProcessing,
+				.delay = 10,
+				.dependencyDepth = dependencyDepth()
+			} );
 	}
 	
 // 	ICore::self()->languageController()->backgroundParser()->addDocument( document(),
@@ -525,18 +649,97 @@ void DSParseJob::reparseLater( int phase ){
 // 		nullptr, FullSequentialProcessing, 500 );
 }
 
+void DSParseJob::requestLazyFiles(){
+	// classes resolved from lazy package files only skimmed so far have no members.
+	// request these files to be fully parsed and build uses again once they finished.
+	// uses resolved during the next run can reference further lazy package files.
+	// these are requested the same way until no more files are missing. the package
+	// phase barriers remember requested files. files failing to reach phase 2 are
+	// not requested again and the waiting job is just not woken up
+	const QSet<IndexedString> &files = pTypeFinder.lazyFiles();
+	if( files.isEmpty() ){
+		return;
+	}
+	
+	ImportPackages &importPackages = DSLanguageSupport::self()->importPackages();
+	QHash<PhaseBarrier::Ref, QSet<IndexedString>> barrierFiles;
+	
+	{
+	DUChainReadLocker lock;
+	BackgroundParser &bp = *ICore::self()->languageController()->backgroundParser();
+	DUChain &duchain = *DUChain::self();
+	
+	foreach( const IndexedString &file, files ){
+		const ImportPackage::Ref package( importPackages.packageContaining( file ) );
+		if( ! package ){
+			continue;
+		}
+		
+		const PhaseBarrier::Ref &barrier = package->phaseBarrier();
+		if( barrier->requestPhase( file, 2 ) && ! bp.isQueued( file ) ){
+			scheduleFileForPhase( file, duchain.chainForDocument( file ), 2 );
+		}
+		
+		barrierFiles[ barrier ] << file;
+	}
+	}
+	
+	const int features = minimumFeatures()
+		| TopDUContext::VisibleDeclarationsAndContexts
+		| Resheduled
+		| phaseFlags( pPhase );
+	
+	const DelayedParsing::ScheduleParameters parameters{
+		.remainingFileCount = 0,
+		.features = static_cast<TopDUContext::Features>( features ),
+		.priority = parsePriority(),
+		.flags = IgnoresSequentialProcessing,
+		.delay = 10,
+		.dependencyDepth = dependencyDepth()
+	};
+	
+	QHash<PhaseBarrier::Ref, QSet<IndexedString>>::const_iterator iter;
+	for( iter = barrierFiles.cbegin(); iter != barrierFiles.cend(); iter++ ){
+		if( ! iter.key()->waitForFiles( document(), iter.value(), 2, parameters ) ){
+			// files finished phase 2 in the mean time
+			DelayedParsing::self().schedule( document(), parameters );
+		}
+	}
+}
+
+int DSParseJob::dependencyDepth() const{
+	int depth = 0;
+	foreach( const ImportPackage::Ref &dependency, pDependencies ){
+		depth = qMax( depth, dependency->dependencyDepth() + 1 );
+	}
+	return depth;
+}
+
 bool DSParseJob::buildDeclaration( EditorIntegrator &editor ){
 	if( duChain() ){
 		DUChainWriteLocker lock;
 		duChain()->clearImportedParentContexts();
 		duChain()->parsingEnvironmentFile()->clearModificationRevisions();
 		duChain()->clearProblems();
+		
+		// builder adds class declarations again
+		ClassIndex::self().removeTopContext( duChain()->ownIndex() );
+		MemberTableCache::self().removeTopContext( duChain()->ownIndex() );
+		CastableCache::self().removeTopContext( duChain()->ownIndex() );
+		NamespaceIndex::self().removeTopContext( duChain()->ownIndex() );
 	}
 	
+	// type names resolved by the declaration builder are reused by the use builder
+	pExpressionMemo.clear();
+	
 	DeclarationBuilder builder( editor, editor.session(), pDependencies, pTypeFinder, pRootNamespace, pPhase );
+	builder.setExpressionMemo( &pExpressionMemo );
 	setDuChain( builder.build( document(), pStartAst, duChain() ) );
 	pRootNamespace = builder.rootNamespace();
 	
+	// declarations can be located at a different place now
+	topContextRebuilt();
+	
 // 	DumpChain().dump( duChain() );
 	if( builder.requiresRebuild() ){
 		pReparsePriority = qMax( pReparsePriority, builder.reparsePriority() + 10 );
@@ -550,6 +753,8 @@ bool DSParseJob::buildDeclaration( EditorIntegrator &editor ){
 bool DSParseJob::buildUses( EditorIntegrator &editor ){
 	// gather uses of variables and functions on the document
 	UseBuilder builder( editor, pDependencies, pTypeFinder, pRootNamespace );
+	builder.setParallelFunctionBodies( QThread::idealThreadCount() > 1 );
+	builder.setExpressionMemo( &pExpressionMemo );
 	builder.buildUses( pStartAst );
 	pRootNamespace = builder.rootNamespace();
 	
@@ -572,6 +777,97 @@ bool DSParseJob::buildUses( EditorIntegrator &editor ){
 	return true;
 }
 
+int DSParseJob::findEditedFunction( ParseSession &session, const QVector<FunctionBodyCache::Body> &bodies ){
+	// rescheduled jobs continue building the phases of the same content
+	if( ( minimumFeatures() & Resheduled ) || ! duChain() || hasParseErrors( session ) ){
+		return -1;
+	}
+	
+	ModificationRevision revision;
+	{
+	DUChainReadLocker lock;
+	if( phaseFromFlags( duChain()->features() ) < 3 || ! duChain()->parsingEnvironmentFile() ){
+		return -1;
+	}
+	revision = duChain()->parsingEnvironmentFile()->modificationRevision();
+	}
+	
+	return FunctionBodyCache::self().editedBody( document(), revision, contents().contents, bodies );
+}
+
+bool DSParseJob::buildEditedFunction( EditorIntegrator &editor, const FunctionBodyCache::Body &body ){
+	// problems of the function are reported again while building it. parser problems
+	// are added again from the parse session
+	{
+	DUChainWriteLocker lock;
+	QList<ProblemPointer> problems;
+	foreach( const ProblemPointer &each, duChain()->problems() ){
+		if( each->source() == IProblem::Parser || each->source() == IProblem::ToDo ){
+			continue;
+		}
+		
+		const KTextEditor::Range range( each->finalLocation() );
+		if( range.end().line() < body.beginLine || range.start().line() > body.endLine ){
+			problems << each;
+		}
+	}
+	duChain()->setProblems( problems );
+	}
+	
+	pExpressionMemo.clear();
+	
+	DeclarationBuilder declarationBuilder( editor, editor.session(), pDependencies, pTypeFinder, pRootNamespace, pPhase );
+	declarationBuilder.setExpressionMemo( &pExpressionMemo );
+	const bool rebuilt = declarationBuilder.buildFunction( duChain(), pStartAst, body.declaration );
+	pRootNamespace = declarationBuilder.rootNamespace();
+	
+	if( ! rebuilt ){
+		return false;
+	}
+	
+	topContextRebuilt();
+	
+	UseBuilder useBuilder( editor, pDependencies, pTypeFinder, pRootNamespace );
+	useBuilder.setExpressionMemo( &pExpressionMemo );
+	useBuilder.buildFunction( duChain(), pStartAst, body.declaration );
+	pRootNamespace = useBuilder.rootNamespace();
+	
+	if( useBuilder.requiresRebuild() ){
+		return false;
+	}
+	
+	const int features = minimumFeatures() | phaseFlags( 3 );
+	DUChainWriteLocker lock;
+	duChain()->setFeatures( static_cast<TopDUContext::Features>( features ) );
+	
+	ParsingEnvironmentFilePointer parsingEnvironmentFile = duChain()->parsingEnvironmentFile();
+	if( parsingEnvironmentFile ){
+		parsingEnvironmentFile->setModificationRevision( contents().modification );
+		DUChain::self()->updateContextEnvironment( duChain(), parsingEnvironmentFile.data() );
+	}
+	
+	return true;
+}
+
+void DSParseJob::storeFunctionBodies( ParseSession &session, const QVector<FunctionBodyCache::Body> &bodies ){
+	// content with parse errors is always built entirely
+	if( hasParseErrors( session ) ){
+		FunctionBodyCache::self().remove( document() );
+		
+	}else{
+		FunctionBodyCache::self().store( document(), contents().modification, contents().contents, bodies );
+	}
+}
+
+bool DSParseJob::hasParseErrors( ParseSession &session ) const{
+	foreach( const ProblemPointer &each, session.problems() ){
+		if( each->source() == IProblem::Parser ){
+			return true;
+		}
+	}
+	return false;
+}
+
 void DSParseJob::parseFailed(){
 	qDebug() << "DSParseJob.parseFailed:" << document();
 	
@@ -607,6 +903,19 @@ void DSParseJob::parseFailed(){
 		DUChain::self()->addDocumentChain( context );
 		setDuChain( context );
 	}
+	
+	topContextRebuilt();
+}
+
+void DSParseJob::topContextRebuilt(){
+	if( ! duChain() ){
+		return;
+	}
+	
+	TypeCache::self().invalidate( duChain()->ownIndex() );
+	
+	DUChainReadLocker lock;
+	NamespaceIndex::self().updateTopContext( duChain() );
 }
 
 void DSParseJob::finishTopContext(){
@@ -13,9 +13,12 @@
 
 #include "DSProjectSettings.h"
 #include "dsp_ast.h"
+#include "FunctionBodyCache.h"
 #include "ImportPackage.h"
 #include "TypeFinder.h"
 #include "Namespace.h"
+#include "PhaseBarrier.h"
+#include "ExpressionMemo.h"
 
 
 using namespace KDevelop;
@@ -70,10 +73,18 @@ protected:
 	void findPackage();
 	void findDependencies();
 	bool allFilesRequiredPhase();
+	void scheduleFileForPhase( const IndexedString &file, TopDUContext *context, int phase );
 	void reparseLater( int phase );
+	void requestLazyFiles();
+	int dependencyDepth() const;
 	bool buildDeclaration( EditorIntegrator &editor );
 	bool buildUses( EditorIntegrator &editor );
+	int findEditedFunction( ParseSession &session, const QVector<FunctionBodyCache::Body> &bodies );
+	bool buildEditedFunction( EditorIntegrator &editor, const FunctionBodyCache::Body &body );
+	void storeFunctionBodies( ParseSession &session, const QVector<FunctionBodyCache::Body> &bodies );
+	bool hasParseErrors( ParseSession &session ) const;
 	void parseFailed();
+	void topContextRebuilt();
 	void finishTopContext();
 	
 	
@@ -85,10 +96,12 @@ private:
 	Namespace::Ref pRootNamespace;
 	ImportPackage::Ref pPackage;
 	QSet<ImportPackage::Ref> pDependencies;
-	QSet<IndexedString> pProjectFiles;
+	PhaseBarrier::Ref pPhaseBarrier;
 	int pReparsePriority;
 	QSet<IndexedString> pWaitForFiles;
+	int pWaitForPhase;
 	int pPhase;
+	ExpressionMemo pExpressionMemo;
 	
 	/**
 	 * Checks if a parent job parses already \p document. Used to prevent
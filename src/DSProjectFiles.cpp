@@ -0,0 +1,177 @@
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <interfaces/icore.h>
+#include <interfaces/idocument.h>
+#include <interfaces/idocumentcontroller.h>
+#include <interfaces/iprojectcontroller.h>
+#include <language/duchain/duchain.h>
+#include <language/duchain/duchainlock.h>
+#include <project/projectmodel.h>
+
+#include "DSProjectFiles.h"
+#include "duchain/NamespaceIndex.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+DSProjectFiles::DSProjectFiles( QObject *parent ) :
+QObject( parent )
+{
+	IProjectController &projectController = *ICore::self()->projectController();
+	
+	connect( &projectController, &IProjectController::projectOpened,
+		this, &DSProjectFiles::projectOpened );
+	connect( &projectController, &IProjectController::projectClosing,
+		this, &DSProjectFiles::projectClosing );
+	connect( ICore::self()->documentController(), &IDocumentController::documentClosed,
+		this, &DSProjectFiles::documentClosed );
+	
+	foreach( IProject * const project, projectController.projects() ){
+		projectOpened( project );
+	}
+}
+
+DSProjectFiles::~DSProjectFiles(){
+}
+
+
+
+QSet<IndexedString> DSProjectFiles::files( IProject *project ){
+	{
+	QReadLocker lock( &pLock );
+	const QHash<IProject*, Project>::const_iterator iter( pProjects.constFind( project ) );
+	if( iter != pProjects.cend() ){
+		return iter->files;
+	}
+	}
+	
+	QWriteLocker lock( &pLock );
+	return projectFor( project ).files;
+}
+
+PhaseBarrier::Ref DSProjectFiles::phaseBarrier( IProject *project ){
+	{
+	QReadLocker lock( &pLock );
+	const QHash<IProject*, Project>::const_iterator iter( pProjects.constFind( project ) );
+	if( iter != pProjects.cend() ){
+		return iter->phaseBarrier;
+	}
+	}
+	
+	QWriteLocker lock( &pLock );
+	return projectFor( project ).phaseBarrier;
+}
+
+bool DSProjectFiles::isScriptFile( const IndexedString &file ){
+	return file.str().endsWith( ".ds" );
+}
+
+
+
+void DSProjectFiles::projectOpened( IProject *project ){
+	QWriteLocker lock( &pLock );
+	projectFor( project );
+}
+
+void DSProjectFiles::projectClosing( IProject *project ){
+	disconnect( project, nullptr, this, nullptr );
+	
+	QSet<IndexedString> files;
+	{
+	QWriteLocker lock( &pLock );
+	files = pProjects.take( project ).files;
+	}
+	
+	removeTopContexts( files );
+}
+
+void DSProjectFiles::documentClosed( IDocument *document ){
+	const IndexedString path( document->url() );
+	if( ! isScriptFile( path ) ){
+		return;
+	}
+	
+	{
+	QReadLocker lock( &pLock );
+	foreach( const Project &project, pProjects ){
+		if( project.files.contains( path ) ){
+			// still used as search context by the project files
+			return;
+		}
+	}
+	}
+	
+	removeTopContexts( QSet<IndexedString>{ path } );
+}
+
+void DSProjectFiles::fileAdded( ProjectFileItem *file ){
+	const IndexedString path( file->indexedPath() );
+	if( ! isScriptFile( path ) ){
+		return;
+	}
+	
+	QWriteLocker lock( &pLock );
+	const QHash<IProject*, Project>::iterator iter( pProjects.find( file->project() ) );
+	if( iter != pProjects.end() ){
+		iter->files.insert( path );
+		iter->phaseBarrier->addFile( path );
+	}
+}
+
+void DSProjectFiles::fileRemoved( ProjectFileItem *file ){
+	const IndexedString path( file->indexedPath() );
+	if( ! isScriptFile( path ) ){
+		return;
+	}
+	
+	QWriteLocker lock( &pLock );
+	const QHash<IProject*, Project>::iterator iter( pProjects.find( file->project() ) );
+	if( iter != pProjects.end() ){
+		iter->files.remove( path );
+		iter->phaseBarrier->removeFile( path );
+	}
+}
+
+
+
+DSProjectFiles::Project &DSProjectFiles::projectFor( IProject *project ){
+	// write lock has to be held
+	QHash<IProject*, Project>::iterator iter( pProjects.find( project ) );
+	if( iter != pProjects.end() ){
+		return *iter;
+	}
+	
+	// first time seen. scan the file set once. afterwards the signals keep it up to date
+	Project &entry = pProjects[ project ];
+	entry.phaseBarrier = PhaseBarrier::Ref( new PhaseBarrier );
+	
+	const QSet<IndexedString> files( project->fileSet() );
+	foreach( const IndexedString &file, files ){
+		if( isScriptFile( file ) ){
+			entry.files << file;
+		}
+	}
+	entry.phaseBarrier->setFiles( entry.files );
+	
+	connect( project, &IProject::fileAddedToSet, this, &DSProjectFiles::fileAdded, Qt::UniqueConnection );
+	connect( project, &IProject::fileRemovedFromSet, this, &DSProjectFiles::fileRemoved, Qt::UniqueConnection );
+	
+	return entry;
+}
+
+void DSProjectFiles::removeTopContexts( const QSet<IndexedString> &files ){
+	DUChainReadLocker lock;
+	DUChain &duchain = *DUChain::self();
+	
+	foreach( const IndexedString &file, files ){
+		TopDUContext * const context = duchain.chainForDocument( file );
+		if( context ){
+			NamespaceIndex::self().removeTopContext( context->ownIndex() );
+		}
+	}
+}
+
+}
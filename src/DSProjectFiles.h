@@ -0,0 +1,83 @@
+#ifndef DSPROJECTFILES_H
+#define DSPROJECTFILES_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QReadWriteLock>
+
+#include <interfaces/iproject.h>
+#include <serialization/indexedstring.h>
+
+#include "duchain/PhaseBarrier.h"
+
+
+namespace KDevelop{
+	class IDocument;
+	class ProjectFileItem;
+}
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+/**
+ * Script files of open projects.
+ * 
+ * Stores the *.ds files of each project together with the phase barrier of the project.
+ * The index is filled once when a project is seen the first time and is then kept up to
+ * date using the project file added and removed signals.
+ * 
+ * Reading the index is thread safe. The returned file sets are implicitly shared.
+ * 
+ * Files of closed projects and closed documents outside open projects are removed
+ * from the namespace index. They are added again if they are used as search context.
+ */
+class DSProjectFiles : public QObject{
+	Q_OBJECT
+	
+public:
+	/** Create project file index. */
+	DSProjectFiles( QObject *parent = nullptr );
+	
+	/** Clean up project file index. */
+	~DSProjectFiles() override;
+	
+	
+	
+	/** Script files of project. */
+	QSet<IndexedString> files( IProject *project );
+	
+	/** Phase barrier of project. */
+	PhaseBarrier::Ref phaseBarrier( IProject *project );
+	
+	/** File is a script file. */
+	static bool isScriptFile( const IndexedString &file );
+	
+	
+	
+private Q_SLOTS:
+	void projectOpened( KDevelop::IProject *project );
+	void projectClosing( KDevelop::IProject *project );
+	void documentClosed( KDevelop::IDocument *document );
+	void fileAdded( KDevelop::ProjectFileItem *file );
+	void fileRemoved( KDevelop::ProjectFileItem *file );
+	
+	
+	
+private:
+	struct Project{
+		QSet<IndexedString> files;
+		PhaseBarrier::Ref phaseBarrier;
+	};
+	
+	Project &projectFor( IProject *project );
+	static void removeTopContexts( const QSet<IndexedString> &files );
+	
+	QReadWriteLock pLock;
+	QHash<IProject*, Project> pProjects;
+};
+
+}
+
+#endif
@@ -24,6 +24,7 @@
 #include "ImportPackageLanguage.h"
 #include "ImportPackageDragengine.h"
 #include "../DSLanguageSupport.h"
+#include "../DSProjectFiles.h"
 
 
 using namespace KDevelop;
@@ -54,12 +55,7 @@ pFollowingText( followingText )
 	
 	IProject * const project = ICore::self()->projectController()->findProjectForUrl( pDocument.toUrl() );
 	if( project ){
-		const QSet<IndexedString> files( project->fileSet() );
-		foreach( const IndexedString &file, files ){
-			if( file.str().endsWith( ".ds" ) ){
-				pProjectFiles << file;
-			}
-		}
+		pProjectFiles = DSLanguageSupport::self()->projectFiles().files( project );
 	}
 }
 
@@ -214,8 +210,7 @@ bool DSCodeCompletionContext::textEndsInsideCommentOrString( const QString &text
 
 void DSCodeCompletionContext::tokenizeText( const QString &expression ){
 	pTokenStreamText = expression.toUtf8();
-	KDevPG::QByteArrayIterator iterContent( pTokenStreamText );
-	Lexer lexer( iterContent );
+	Lexer lexer( pTokenStreamText );
 	bool endOfStream = false;
 	
 	while( ! endOfStream ){
@@ -267,7 +262,7 @@ void DSCodeCompletionContext::prepareTypeFinder(){
 	// NOTE do not use duchain.chainForDocument(pIndexDocument). it is not going to work
 	//      because the current document is altered for code completion and thus the
 	//      chain returned for pIndexDocument is outdated and not working
-	pTypeFinder.searchContexts() << m_duContext->topContext();
+	pTypeFinder.addSearchContext( m_duContext->topContext() );
 	
 	foreach( const IndexedString &file, files ){
 		if( file == pDocument ){
@@ -276,7 +271,7 @@ void DSCodeCompletionContext::prepareTypeFinder(){
 		
 		TopDUContext * const context = duchain.chainForDocument( file );
 		if( context ){
-			pTypeFinder.searchContexts() << context;
+			pTypeFinder.addSearchContext( context );
 		}
 	}
 	
@@ -292,18 +287,9 @@ void DSCodeCompletionContext::prepareTypeFinder(){
 }
 
 void DSCodeCompletionContext::preparePackage( ImportPackage &package ){
-	DUChain &duchain = *DUChain::self();
-	
-	foreach( const IndexedString &file, package.files() ){
-		TopDUContext * const context = duchain.chainForDocument( file );
-		if( context ){
-			pTypeFinder.searchContexts() << context;
-		}
-	}
-	
-	const QSet<ImportPackage::Ref> &dependsOn = package.dependsOn();
-	foreach( const ImportPackage::Ref &dependency, dependsOn ){
-		preparePackage( *dependency );
+	// package caches the contexts of itself and all dependencies
+	foreach( TopDUContext *context, package.deepAllContexts() ){
+		pTypeFinder.addSearchContext( context );
 	}
 }
 
@@ -0,0 +1,107 @@
+#include <QMutexLocker>
+#include <QThread>
+
+#include <language/duchain/duchain.h>
+#include <language/duchain/duchainlock.h>
+
+#include "BuilderLock.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+// global statistics
+QMutex BuilderLock::pStatisticsMutex;
+BuilderLock::Statistics BuilderLock::pStatistics = {};
+
+
+BuilderLock::BuilderLock( int budget ) :
+pBudget( budget ),
+pReadOnly( false ),
+pLocked( false ){
+}
+
+BuilderLock::~BuilderLock(){
+	unlock();
+}
+
+
+
+void BuilderLock::setBudget( int budget ){
+	pBudget = budget;
+}
+
+void BuilderLock::setReadOnly( bool readOnly ){
+	Q_ASSERT( ! pLocked );
+	pReadOnly = readOnly;
+}
+
+void BuilderLock::lock(){
+	if( pLocked ){
+		return;
+	}
+	
+	QElapsedTimer waitTimer;
+	waitTimer.start();
+	if( pReadOnly ){
+		DUChain::lock()->lockForRead();
+		
+	}else{
+		DUChain::lock()->lockForWrite();
+	}
+	const qint64 waitTime = waitTimer.nsecsElapsed();
+	
+	pLocked = true;
+	pHoldTimer.start();
+	
+	QMutexLocker lock( &pStatisticsMutex );
+	pStatistics.acquireCount++;
+	pStatistics.totalWaitTime += waitTime;
+	pStatistics.maxWaitTime = qMax( pStatistics.maxWaitTime, waitTime );
+}
+
+void BuilderLock::unlock(){
+	if( ! pLocked ){
+		return;
+	}
+	
+	const qint64 holdTime = pHoldTimer.nsecsElapsed();
+	if( pReadOnly ){
+		DUChain::lock()->releaseReadLock();
+		
+	}else{
+		DUChain::lock()->releaseWriteLock();
+	}
+	pLocked = false;
+	
+	QMutexLocker lock( &pStatisticsMutex );
+	pStatistics.totalHoldTime += holdTime;
+	pStatistics.maxHoldTime = qMax( pStatistics.maxHoldTime, holdTime );
+}
+
+bool BuilderLock::yield(){
+	if( ! pLocked || ! pHoldTimer.hasExpired( pBudget ) ){
+		return false;
+	}
+	
+	unlock();
+	QThread::yieldCurrentThread();
+	lock();
+	
+	QMutexLocker lock( &pStatisticsMutex );
+	pStatistics.yieldCount++;
+	return true;
+}
+
+BuilderLock::Statistics BuilderLock::statistics(){
+	QMutexLocker lock( &pStatisticsMutex );
+	return pStatistics;
+}
+
+void BuilderLock::resetStatistics(){
+	QMutexLocker lock( &pStatisticsMutex );
+	pStatistics = {};
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef BUILDERLOCK_H
+#define BUILDERLOCK_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+
+namespace DragonScript{
+
+/**
+ * DUChain lock held by builders across a batch of work.
+ *
+ * Builders lock and unlock the DUChain for nearly every look-up they do. Instead the
+ * builder holds one lock while visiting and calls yield() at statement and member
+ * boundaries. The lock is released and re-acquired there if it has been held longer
+ * than the time budget. This allows the editor to get the lock without the builder
+ * paying for lock traffic on every look-up.
+ *
+ * Builders only reading the DUChain hold a read lock and commit their changes
+ * afterwards under a short write lock.
+ *
+ * Lockers created while the batch lock is held are recursive and do not block. Write
+ * lockers must not be created while the read lock is held.
+ *
+ * Statistics are collected across all builders and are thread safe.
+ */
+class BuilderLock{
+public:
+	/**
+	 * Lock statistics. Times are in nano-seconds.
+	 */
+	struct Statistics{
+		quint64 acquireCount;
+		quint64 yieldCount;
+		qint64 totalWaitTime;
+		qint64 maxWaitTime;
+		qint64 totalHoldTime;
+		qint64 maxHoldTime;
+	};
+	
+	/** Default time budget in milli-seconds. */
+	static const int defaultBudget = 10;
+	
+	
+	
+	/** Create unlocked batch lock. */
+	BuilderLock( int budget = defaultBudget );
+	
+	/** Unlocks if locked. */
+	~BuilderLock();
+	
+	
+	
+	/** Time budget in milli-seconds. */
+	inline int budget() const{ return pBudget; }
+	
+	/** Set time budget in milli-seconds. */
+	void setBudget( int budget );
+	
+	/** Read lock is used instead of write lock. */
+	inline bool readOnly() const{ return pReadOnly; }
+	
+	/** Set if read lock is used instead of write lock. Only allowed while not locked. */
+	void setReadOnly( bool readOnly );
+	
+	/** Lock is held. */
+	inline bool locked() const{ return pLocked; }
+	
+	/** Acquire lock if not held. */
+	void lock();
+	
+	/** Release lock if held. */
+	void unlock();
+	
+	/**
+	 * Release and re-acquire lock if held longer than the time budget. Returns true if
+	 * the lock has been released. Caller has to drop pointers into other top contexts.
+	 */
+	bool yield();
+	
+	
+	
+	/** Retrieve statistics. */
+	static Statistics statistics();
+	
+	/** Reset statistics. */
+	static void resetStatistics();
+	
+	
+	
+private:
+	int pBudget;
+	bool pReadOnly;
+	bool pLocked;
+	QElapsedTimer pHoldTimer;
+	
+	static QMutex pStatisticsMutex;
+	static Statistics pStatistics;
+};
+
+}
+
+#endif
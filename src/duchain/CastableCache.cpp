@@ -0,0 +1,71 @@
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include "CastableCache.h"
+#include "TypeFinder.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+// global instance
+CastableCache CastableCache::pSelf;
+
+
+bool CastableCache::castable( const IndexedType &type, const IndexedType &targetType,
+TypeFinder &typeFinder, bool &castable, QSet<uint> &topContexts ){
+	Entry entry;
+	{
+	QReadLocker lock( &pLock );
+	const QHash<Key, Entry>::const_iterator iter( pEntries.constFind( Key( type, targetType ) ) );
+	if( iter == pEntries.constEnd() ){
+		return false;
+	}
+	entry = *iter;
+	}
+	
+	foreach( uint topContext, entry.topContexts ){
+		if( ! typeFinder.isSearchContext( topContext ) ){
+			return false;
+		}
+	}
+	
+	castable = entry.castable;
+	topContexts = entry.topContexts;
+	return true;
+}
+
+void CastableCache::add( const IndexedType &type, const IndexedType &targetType, bool castable,
+const QSet<uint> &topContexts ){
+	const Key key( type, targetType );
+	
+	QWriteLocker lock( &pLock );
+	pEntries.insert( key, Entry{ castable, topContexts } );
+	foreach( uint topContext, topContexts ){
+		pContextEntries[ topContext ].insert( key );
+	}
+}
+
+void CastableCache::removeTopContext( uint topContextIndex ){
+	QWriteLocker lock( &pLock );
+	
+	const QSet<Key> keys( pContextEntries.take( topContextIndex ) );
+	foreach( const Key &key, keys ){
+		const Entry entry( pEntries.take( key ) );
+		
+		// drop references of the other visited top contexts to the removed result
+		foreach( uint topContext, entry.topContexts ){
+			const QHash<uint, QSet<Key>>::iterator iter( pContextEntries.find( topContext ) );
+			if( iter == pContextEntries.end() ){
+				continue;
+			}
+			iter->remove( key );
+			if( iter->isEmpty() ){
+				pContextEntries.erase( iter );
+			}
+		}
+	}
+}
+
+}
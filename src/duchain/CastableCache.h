@@ -0,0 +1,74 @@
+#ifndef CASTABLECACHE_H
+#define CASTABLECACHE_H
+
+#include <language/duchain/types/indexedtype.h>
+
+#include <QHash>
+#include <QSet>
+#include <QPair>
+#include <QReadWriteLock>
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+class TypeFinder;
+
+/**
+ * Global memo of the castable relation between types.
+ * 
+ * Helpers::castable() walks the super class and interfaces of a type recursively to find
+ * the target type. The result is stored per type pair together with the top contexts
+ * of all classes visited. Before a top context is rebuilt all results depending on it
+ * are dropped.
+ * 
+ * Results are only used if all visited top contexts are search contexts of the type
+ * finder asking. Otherwise the hierarchy could resolve differently for the job.
+ * 
+ * This class works as singleton and is thread safe.
+ */
+class CastableCache{
+public:
+	/** Global instance. */
+	static inline CastableCache &self(){ return pSelf; }
+	
+	
+	
+	/**
+	 * Get cached castable result. Returns false if not cached. \em topContexts is set to
+	 * the top contexts the result depends on.
+	 * \note DUChainReadLocker required.
+	 */
+	bool castable( const IndexedType &type, const IndexedType &targetType,
+		TypeFinder &typeFinder, bool &castable, QSet<uint> &topContexts );
+	
+	/** Add castable result depending on top contexts. */
+	void add( const IndexedType &type, const IndexedType &targetType, bool castable,
+		const QSet<uint> &topContexts );
+	
+	/** Remove all results depending on top context. */
+	void removeTopContext( uint topContextIndex );
+	
+	
+	
+private:
+	typedef QPair<IndexedType, IndexedType> Key;
+	
+	struct Entry{
+		bool castable;
+		QSet<uint> topContexts;
+	};
+	
+	CastableCache() = default;
+	
+	static CastableCache pSelf;
+	
+	QReadWriteLock pLock;
+	QHash<Key, Entry> pEntries;
+	QHash<uint, QSet<Key>> pContextEntries;
+};
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <language/duchain/topducontext.h>
+
+#include "ClassIndex.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+// global instance
+ClassIndex ClassIndex::pSelf;
+
+
+void ClassIndex::add( ClassDeclaration *declaration ){
+	if( ! declaration ){
+		return;
+	}
+	
+	const IndexedQualifiedIdentifier identifier( declaration->qualifiedIdentifier() );
+	const IndexedDeclaration indexed( declaration );
+	
+	QWriteLocker lock( &pLock );
+	QVector<IndexedDeclaration> &list = pDeclarations[ identifier ];
+	if( ! list.contains( indexed ) ){
+		list << indexed;
+	}
+	pContextIdentifiers[ indexed.topContextIndex() ].insert( identifier );
+}
+
+QVector<ClassDeclaration*> ClassIndex::declarationsFor( const IndexedQualifiedIdentifier &identifier ){
+	QVector<IndexedDeclaration> list;
+	{
+	QReadLocker lock( &pLock );
+	list = pDeclarations.value( identifier );
+	}
+	
+	QVector<ClassDeclaration*> declarations;
+	foreach( const IndexedDeclaration &each, list ){
+		// verify the declaration still matches in case the context is rebuilt right now
+		ClassDeclaration * const declaration = dynamic_cast<ClassDeclaration*>( each.declaration() );
+		if( declaration && declaration->qualifiedIdentifier() == identifier.identifier() ){
+			declarations << declaration;
+		}
+	}
+	return declarations;
+}
+
+void ClassIndex::removeTopContext( uint topContextIndex ){
+	QWriteLocker lock( &pLock );
+	
+	const QSet<IndexedQualifiedIdentifier> identifiers( pContextIdentifiers.take( topContextIndex ) );
+	foreach( const IndexedQualifiedIdentifier &identifier, identifiers ){
+		const QHash<IndexedQualifiedIdentifier, QVector<IndexedDeclaration>>::iterator
+			iter( pDeclarations.find( identifier ) );
+		if( iter == pDeclarations.end() ){
+			continue;
+		}
+		
+		QVector<IndexedDeclaration>::iterator iterDecl( iter->begin() );
+		while( iterDecl != iter->end() ){
+			if( iterDecl->topContextIndex() == topContextIndex ){
+				iterDecl = iter->erase( iterDecl );
+				
+			}else{
+				iterDecl++;
+			}
+		}
+		
+		if( iter->isEmpty() ){
+			pDeclarations.erase( iter );
+		}
+	}
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef CLASSINDEX_H
+#define CLASSINDEX_H
+
+#include <language/duchain/classdeclaration.h>
+#include <language/duchain/indexeddeclaration.h>
+#include <language/duchain/identifier.h>
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QReadWriteLock>
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+/**
+ * Global index of class declarations by qualified identifier.
+ * 
+ * DeclarationBuilder adds class, interface and enumeration declarations while building.
+ * Before a top context is rebuilt all its entries are removed. Types can then be
+ * resolved to their class declaration using a single hash look-up instead of asking
+ * every search context to resolve the type.
+ * 
+ * Contexts loaded from the DUChain store are not built and thus not indexed. Callers
+ * have to fall back to searching contexts if no declaration is found.
+ * 
+ * This class works as singleton and is thread safe.
+ */
+class ClassIndex{
+public:
+	/** Global instance. */
+	static inline ClassIndex &self(){ return pSelf; }
+	
+	
+	
+	/**
+	 * Add class declaration.
+	 * \note DUChainReadLocker required.
+	 */
+	void add( ClassDeclaration *declaration );
+	
+	/**
+	 * Class declarations with qualified identifier.
+	 * \note DUChainReadLocker required.
+	 */
+	QVector<ClassDeclaration*> declarationsFor( const IndexedQualifiedIdentifier &identifier );
+	
+	/** Remove all declarations located in top context. */
+	void removeTopContext( uint topContextIndex );
+	
+	
+	
+private:
+	ClassIndex() = default;
+	
+	static ClassIndex pSelf;
+	
+	QReadWriteLock pLock;
+	QHash<IndexedQualifiedIdentifier, QVector<IndexedDeclaration>> pDeclarations;
+	QHash<uint, QSet<IndexedQualifiedIdentifier>> pContextIdentifiers;
+};
+
+}
+
+#endif
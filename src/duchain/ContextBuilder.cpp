@@ -32,6 +32,10 @@ void ContextBuilder::setRootNamespace( Namespace::Ref &rootNamespace ){
 	pCurNamespace = rootNamespace.data();
 }
 
+void ContextBuilder::setExpressionMemo( ExpressionMemo *memo ){
+	pExpressionMemo = memo;
+}
+
 void ContextBuilder::setDependencies( const QSet<ImportPackage::Ref> &deps ){
 	pDependencies = deps;
 }
@@ -80,10 +84,23 @@ void ContextBuilder::setReparsePriority( int priority ){
 }
 
 void ContextBuilder::startVisiting( AstNode *node ){
-	if( ! pTypeFinder ){
+	if( ! prepareBuild() ){
 		return;
 	}
 	
+	// visit node to start building. the lock is held across the visit to avoid locking
+	// for every single look-up. builders yield it periodically
+	pBatchLock.lock();
+	visitNode( node );
+	closeNamespaceContexts();
+	pBatchLock.unlock();
+}
+
+bool ContextBuilder::prepareBuild(){
+	if( ! pTypeFinder ){
+		return false;
+	}
+	
 	if( ! pDependencies.isEmpty() ){
 		DUChainWriteLocker lock;
 		foreach( const ImportPackage::Ref &each, pDependencies ){
@@ -91,18 +108,16 @@ void ContextBuilder::startVisiting( AstNode *node ){
 		}
 		
 		if( pRequiresRebuild ){
-			return;
+			return false;
 		}
 	}
 	
 	if( ! *pRootNamespace ){
+		DUChainReadLocker lock;
 		*pRootNamespace = Namespace::Ref( new Namespace( *pTypeFinder ) );
 	}
 	pCurNamespace = pRootNamespace->data();
-	
-	// visit node to start building
-	visitNode( node );
-	closeNamespaceContexts();
+	return true;
 }
 
 void ContextBuilder::preparePackage( ImportPackage &package ){
@@ -110,7 +125,7 @@ void ContextBuilder::preparePackage( ImportPackage &package ){
 	package.contexts( state, 2 ); // classes and declarations are enough. uses not required
 	if( state.ready ){
 		foreach( TopDUContext *each, state.importContexts ){
-			pTypeFinder->searchContexts() << each;
+			pTypeFinder->addSearchContext( each );
 		}
 		
 	}else{
@@ -126,6 +141,77 @@ void ContextBuilder::preparePackage( ImportPackage &package ){
 	}
 }
 
+void ContextBuilder::restoreNamespaces( StartAst *start, AstNode *node ){
+	pCurNamespace = pRootNamespace->data();
+	pPinnedNamespaces.clear();
+	pSearchNamespaces.clear();
+	
+	if( ! start->scriptSequence ){
+		return;
+	}
+	
+	// namespace and pin statements before node in the order the builders visit them
+	const KDevPG::ListNode<ScriptAst*> *iter = start->scriptSequence->front();
+	const KDevPG::ListNode<ScriptAst*> *end = iter;
+	
+	do{
+		const ScriptAst &script = *iter->element;
+		if( script.startToken > node->startToken ){
+			break;
+		}
+		
+		const FullyQualifiedClassnameAst * const name = script.pin ? script.pin->name
+			: ( script.anamespace ? script.anamespace->name : nullptr );
+		
+		if( name && name->nameSequence ){
+			const KDevPG::ListNode<IdentifierAst*> *iterName = name->nameSequence->front();
+			const KDevPG::ListNode<IdentifierAst*> *endName = iterName;
+			Namespace *ns = pRootNamespace->data();
+			
+			do{
+				ns = &ns->getOrAddNamespace( pEditor->tokenText( *iterName->element ) );
+				iterName = iterName->next;
+			}while( iterName != endName );
+			
+			if( script.pin ){
+				addPinnedUpdateNamespaces( ns );
+				
+			}else{
+				pCurNamespace = ns;
+				updateSearchNamespaces();
+			}
+		}
+		
+		iter = iter->next;
+	}while( iter != end );
+}
+
+int ContextBuilder::openParentContexts( DUContext *context ){
+	QVector<DUContext*> contexts;
+	while( context ){
+		contexts.prepend( context );
+		context = context->parentContext();
+	}
+	
+	foreach( DUContext *each, contexts ){
+		ContextBuilderBase::openContext( each );
+	}
+	return contexts.size();
+}
+
+void ContextBuilder::closeParentContexts( int count ){
+	// closing contexts while compiling removes everything not encountered
+	const bool compiling = compilingContexts();
+	setCompilingContexts( false );
+	
+	while( count > 0 ){
+		ContextBuilderBase::closeContext();
+		count--;
+	}
+	
+	setCompilingContexts( compiling );
+}
+
 void ContextBuilder::setContextOnNode( AstNode *node, DUContext *context ){
 	node->ducontext = context;
 }
@@ -171,6 +257,16 @@ void ContextBuilder::closeNamespaceContexts(){
 	}
 }
 
+void ContextBuilder::openNamespaceContext( AstNode *node ){
+	DUContext * const context = contextFromNode( node );
+	if( ! context ){
+		return;
+	}
+	
+	openContext( context );
+	pNamespaceContextCount++;
+}
+
 void ContextBuilder::openContextClass( ClassAst *node ){
 	// context starts at the end of the declaration
 	const CursorInRevision cursorBegin( pEditor->findPosition( *node->begin, EditorIntegrator::BackEdge ) );
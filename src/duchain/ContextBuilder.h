@@ -10,6 +10,8 @@
 
 #include "dsp_defaultvisitor.h"
 #include "duchainexport.h"
+#include "BuilderLock.h"
+#include "ExpressionMemo.h"
 #include "ImportPackage.h"
 #include "Namespace.h"
 
@@ -40,6 +42,8 @@ private:
 	QSet<IndexedString> pWaitForFiles;
 	TypeFinder *pTypeFinder = nullptr;
 	Namespace::Ref *pRootNamespace = nullptr;
+	BuilderLock pBatchLock;
+	ExpressionMemo *pExpressionMemo = nullptr;
 	
 	
 	
@@ -55,6 +59,10 @@ public:
 	inline Namespace::Ref &rootNamespace(){ return *pRootNamespace; }
 	void setRootNamespace( Namespace::Ref &rootNamespace );
 	
+	/** Memo of resolved type names or nullptr. */
+	inline ExpressionMemo *expressionMemo() const{ return pExpressionMemo; }
+	void setExpressionMemo( ExpressionMemo *memo );
+	
 	inline const QSet<ImportPackage::Ref> &dependencies() const{ return pDependencies; }
 	void setDependencies( const QSet<ImportPackage::Ref> &deps );
 	
@@ -78,13 +86,49 @@ public:
 	inline QSet<IndexedString> &waitForFiles(){ return pWaitForFiles; }
 	inline const QSet<IndexedString> &waitForFiles() const{ return pWaitForFiles; }
 	
+	/**
+	 * DUChain lock held while visiting. Builders call BuilderLock::yield() at
+	 * statement and member boundaries to let other threads access the DUChain.
+	 */
+	inline BuilderLock &batchLock(){ return pBatchLock; }
+	
 	void startVisiting( AstNode *node ) override;
 	
+	/**
+	 * \brief Add dependencies to type finder and create root namespace if absent.
+	 * Returns false if building is not possible yet.
+	 */
+	bool prepareBuild();
+	
 	void preparePackage( ImportPackage &package );
 	
+	/**
+	 * \brief Restore namespaces in effect at \p node without visiting the script.
+	 * Used to build parts of the document.
+	 */
+	void restoreNamespaces( StartAst *start, AstNode *node );
+	
+	/**
+	 * \brief Open \p context and its parents to build content inside \p context.
+	 * Returns the number of opened contexts.
+	 */
+	int openParentContexts( DUContext *context );
+	
+	/**
+	 * \brief Close contexts opened by \ref openParentContexts.
+	 * The contexts are left untouched.
+	 */
+	void closeParentContexts( int count );
+	
 	/** \brief Close namespace contexts. */
 	void closeNamespaceContexts();
 	
+	/**
+	 * \brief Open namespace context previously set on \p node.
+	 * Closed by \ref closeNamespaceContexts.
+	 */
+	void openNamespaceContext( AstNode *node );
+	
 	/**
 	 * \brief Set \p context as the context of \p node.
 	 * The context is stored inside the AST itself.
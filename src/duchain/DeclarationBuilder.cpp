@@ -16,6 +16,7 @@
 #include "ExpressionVisitor.h"
 #include "Helpers.h"
 #include "TypeFinder.h"
+#include "ClassIndex.h"
 #include "DumpChain.h"
 #include "../parser/ParseSession.h"
 
@@ -58,6 +59,58 @@ QString DeclarationBuilder::getDocumentationForNode( const AstNode &node ) const
 	return pParseSession.documentation( node );
 }
 
+bool DeclarationBuilder::buildFunction( const ReferencedTopDUContext &top, StartAst *start,
+ClassBodyDeclarationAst *node ){
+	if( ! node->function || ! node->function->end || ! prepareBuild() ){
+		return false;
+	}
+	
+	batchLock().lock();
+	
+	// find function context and declaration of the last build
+	DUContext *functionContext = top->findContextAt( editor()->findPosition(
+		*node->function->end, EditorIntegrator::FrontEdge ) );
+	while( functionContext && functionContext->type() != DUContext::Function ){
+		functionContext = functionContext->parentContext();
+	}
+	
+	DUContext * const classContext = functionContext ? functionContext->parentContext() : nullptr;
+	Declaration * const functionDecl = functionContext ? functionContext->owner() : nullptr;
+	
+	if( ! classContext || ! functionDecl || functionDecl->context() != classContext ){
+		batchLock().unlock();
+		return false;
+	}
+	
+	restoreNamespaces( start, node );
+	
+	// the function context is matched by range. the scope identifier is set again
+	// once the function arguments are known
+	functionContext->setLocalScopeIdentifier( QualifiedIdentifier() );
+	
+	setCompilingContexts( true );
+	setRecompiling( true );
+	
+	const int openedCount = openParentContexts( classContext );
+	visitNode( node );
+	closeParentContexts( openedCount );
+	
+	// drop function declaration and context of the last build if not reused. uses in
+	// other functions still point to the old declaration in this case
+	const bool reused = wasEncountered( functionDecl ) && wasEncountered( functionContext );
+	
+	const DUContextPointer oldContext( functionContext );
+	if( ! wasEncountered( functionDecl ) ){
+		delete functionDecl;
+	}
+	if( oldContext && ! wasEncountered( oldContext.data() ) ){
+		delete oldContext.data();
+	}
+	
+	batchLock().unlock();
+	return reused;
+}
+
 
 
 void DeclarationBuilder::visitStart( StartAst *node ){
@@ -75,6 +128,7 @@ void DeclarationBuilder::visitScript( ScriptAst *node ){
 }
 
 void DeclarationBuilder::visitScriptDeclaration( ScriptDeclarationAst *node ){
+	batchLock().yield();
 	pLastModifiers = etmNone;
 	DeclarationBuilderBase::visitScriptDeclaration( node );
 }
@@ -214,6 +268,7 @@ void DeclarationBuilder::visitClass( ClassAst *node ){
 			DUChainReadLocker lock;
 			ExpressionVisitor exprvisitor( *editor(), currentContext(),
 				searchNamespaces(), *typeFinder(), *rootNamespace().data() );
+			exprvisitor.setExpressionMemo( expressionMemo() );
 			exprvisitor.visitNode( node->begin->extends );
 			
 			if( exprvisitor.lastType()
@@ -248,6 +303,7 @@ void DeclarationBuilder::visitClass( ClassAst *node ){
 			do{
 				ExpressionVisitor exprvisitor( *editor(), currentContext(),
 					searchNamespaces(), *typeFinder(), *rootNamespace().data() );
+				exprvisitor.setExpressionMemo( expressionMemo() );
 				exprvisitor.visitNode( iter->element );
 				if( exprvisitor.lastType() && exprvisitor.lastType()->whichType() == AbstractType::TypeStructure ){
 					const StructureType::Ptr baseType( exprvisitor.lastType().dynamicCast<StructureType>() );
@@ -276,9 +332,12 @@ void DeclarationBuilder::visitClass( ClassAst *node ){
 	closeType();
 	eventuallyAssignInternalContext();
 	closeDeclaration();
+	
+	addToClassIndex( decl );
 }
 
 void DeclarationBuilder::visitClassBodyDeclaration( ClassBodyDeclarationAst *node ){
+	batchLock().yield();
 	pLastModifiers = 0;
 	DeclarationBuilderBase::visitClassBodyDeclaration( node );
 }
@@ -296,6 +355,7 @@ void DeclarationBuilder::visitClassVariablesDeclare( ClassVariablesDeclareAst *n
 	DUChainReadLocker lock;
 	ExpressionVisitor exprType( *editor(), currentContext(), searchNamespaces(),
 		*typeFinder(), *rootNamespace().data() );
+	exprType.setExpressionMemo( expressionMemo() );
 	exprType.visitNode( node->type );
 	type = exprType.lastType();
 	}
@@ -379,6 +439,7 @@ void DeclarationBuilder::visitClassFunctionDeclare( ClassFunctionDeclareAst *nod
 		DUChainReadLocker lock;
 		ExpressionVisitor exprRetType( *editor(), currentContext(), searchNamespaces(),
 			*typeFinder(), *rootNamespace().data() );
+		exprRetType.setExpressionMemo( expressionMemo() );
 		exprRetType.setAllowVoid( true );
 		exprRetType.visitNode( node->begin->type );
 		funcType->setReturnType( exprRetType.lastType() );
@@ -414,6 +475,7 @@ void DeclarationBuilder::visitClassFunctionDeclare( ClassFunctionDeclareAst *nod
 			DUChainReadLocker lock;
 			ExpressionVisitor exprArgType( *editor(), currentContext(), searchNamespaces(),
 				*typeFinder(), *rootNamespace().data() );
+			exprArgType.setExpressionMemo( expressionMemo() );
 			exprArgType.visitNode( iter->element->type );
 			argType = exprArgType.lastType();
 			}
@@ -456,6 +518,7 @@ void DeclarationBuilder::visitClassFunctionDeclare( ClassFunctionDeclareAst *nod
 		}
 		
 		do{
+			batchLock().yield();
 			visitNode( iter->element );
 			iter = iter->next;
 		}while( iter != end );
@@ -499,6 +562,7 @@ void DeclarationBuilder::visitInterface( InterfaceAst *node ){
 			do{
 				ExpressionVisitor exprvisitor( *editor(), currentContext(), searchNamespaces(),
 					*typeFinder(), *rootNamespace().data() );
+				exprvisitor.setExpressionMemo( expressionMemo() );
 				exprvisitor.visitNode( iter->element );
 				if( exprvisitor.lastType() && exprvisitor.lastType()->whichType() == AbstractType::TypeStructure ){
 					const StructureType::Ptr baseType( exprvisitor.lastType().dynamicCast<StructureType>() );
@@ -527,9 +591,12 @@ void DeclarationBuilder::visitInterface( InterfaceAst *node ){
 	closeType();
 	eventuallyAssignInternalContext();
 	closeDeclaration();
+	
+	addToClassIndex( decl );
 }
 
 void DeclarationBuilder::visitInterfaceBodyDeclaration( InterfaceBodyDeclarationAst *node ){
+	batchLock().yield();
 	pLastModifiers = 0;
 	DeclarationBuilderBase::visitInterfaceBodyDeclaration( node );
 }
@@ -567,6 +634,7 @@ void DeclarationBuilder::visitInterfaceFunctionDeclare( InterfaceFunctionDeclare
 	DUChainReadLocker lock;
 	ExpressionVisitor exprRetType( *editor(), currentContext(), searchNamespaces(),
 		*typeFinder(), *rootNamespace().data() );
+	exprRetType.setExpressionMemo( expressionMemo() );
 	exprRetType.setAllowVoid( true );
 	exprRetType.visitNode( node->begin->type );
 	funcType->setReturnType( exprRetType.lastType() );
@@ -584,6 +652,7 @@ void DeclarationBuilder::visitInterfaceFunctionDeclare( InterfaceFunctionDeclare
 			DUChainReadLocker lock;
 			ExpressionVisitor exprArgType( *editor(), currentContext(), searchNamespaces(),
 				*typeFinder(), *rootNamespace().data() );
+			exprArgType.setExpressionMemo( expressionMemo() );
 			exprArgType.visitNode( iter->element->type );
 			argType = exprArgType.lastType();
 			}
@@ -683,6 +752,8 @@ void DeclarationBuilder::visitEnumeration( EnumerationAst *node ){
 	closeType();
 	eventuallyAssignInternalContext();
 	closeDeclaration();
+	
+	addToClassIndex( decl );
 }
 
 void DeclarationBuilder::visitEnumerationEntry( EnumerationEntryAst *node ){
@@ -726,6 +797,7 @@ void DeclarationBuilder::visitExpressionBlock( ExpressionBlockAst *node ){
 			DUChainReadLocker lock;
 			ExpressionVisitor exprArgType( *editor(), currentContext(), searchNamespaces(),
 				*typeFinder(), *rootNamespace().data() );
+			exprArgType.setExpressionMemo( expressionMemo() );
 			exprArgType.visitNode( iter->element->type );
 			argType = exprArgType.lastType();
 			}
@@ -758,6 +830,7 @@ void DeclarationBuilder::visitStatementIf( StatementIfAst *node ){
 		openContext( iter->element, node->bodySequence->back()->element, DUContext::Other );
 		
 		do{
+			batchLock().yield();
 			visitNode( iter->element );
 			iter = iter->next;
 		}while( iter != end );
@@ -786,6 +859,7 @@ void DeclarationBuilder::visitStatementIf( StatementIfAst *node ){
 	openContext( iter->element, node->elseSequence->back()->element, DUContext::Other );
 	
 	do{
+		batchLock().yield();
 		visitNode( iter->element );
 		iter = iter->next;
 	}while( iter != end );
@@ -808,6 +882,7 @@ void DeclarationBuilder::visitStatementElif( StatementElifAst *node ){
 	openContext( iter->element, node->bodySequence->back()->element, DUContext::Other );
 	
 	do{
+		batchLock().yield();
 		visitNode( iter->element );
 		iter = iter->next;
 	}while( iter != end );
@@ -841,6 +916,7 @@ void DeclarationBuilder::visitStatementSelect( StatementSelectAst *node ){
 	openContext( iter->element, node->elseSequence->back()->element, DUContext::Other );
 	
 	do{
+		batchLock().yield();
 		visitNode( iter->element );
 		iter = iter->next;
 	}while( iter != end );
@@ -870,6 +946,7 @@ void DeclarationBuilder::visitStatementCase( StatementCaseAst *node ){
 	openContext( iter->element, node->bodySequence->back()->element, DUContext::Other );
 	
 	do{
+		batchLock().yield();
 		visitNode( iter->element );
 		iter = iter->next;
 	}while( iter != end );
@@ -896,6 +973,7 @@ void DeclarationBuilder::visitStatementFor( StatementForAst *node ){
 	openContext( iter->element, node->bodySequence->back()->element, DUContext::Other );
 	
 	do{
+		batchLock().yield();
 		visitNode( iter->element );
 		iter = iter->next;
 	}while( iter != end );
@@ -918,6 +996,7 @@ void DeclarationBuilder::visitStatementWhile( StatementWhileAst *node ){
 	openContext( iter->element, node->bodySequence->back()->element, DUContext::Other );
 	
 	do{
+		batchLock().yield();
 		visitNode( iter->element );
 		iter = iter->next;
 	}while( iter != end );
@@ -936,6 +1015,7 @@ void DeclarationBuilder::visitStatementTry( StatementTryAst *node ){
 		
 		iter = node->bodySequence->front();
 		do{
+			batchLock().yield();
 			visitNode( iter->element );
 			iter = iter->next;
 		}while( iter != end );
@@ -964,6 +1044,7 @@ void DeclarationBuilder::visitStatementCatch( StatementCatchAst *node ){
 		DUChainReadLocker lock;
 		ExpressionVisitor exprType( *editor(), currentContext(), searchNamespaces(),
 			*typeFinder(), *rootNamespace().data() );
+		exprType.setExpressionMemo( expressionMemo() );
 		exprType.visitNode( node->type );
 		type = exprType.lastType();
 		}
@@ -979,6 +1060,7 @@ void DeclarationBuilder::visitStatementCatch( StatementCatchAst *node ){
 		const KDevPG::ListNode<StatementAst*> *iter = node->bodySequence->front();
 		const KDevPG::ListNode<StatementAst*> *end = iter;
 		do{
+			batchLock().yield();
 			visitNode( iter->element );
 			iter = iter->next;
 		}while( iter != end );
@@ -999,6 +1081,7 @@ void DeclarationBuilder::visitStatementVariableDefinitions( StatementVariableDef
 	DUChainReadLocker lock;
 	ExpressionVisitor exprType( *editor(), currentContext(), searchNamespaces(),
 		*typeFinder(), *rootNamespace().data() );
+	exprType.setExpressionMemo( expressionMemo() );
 	exprType.visitNode( node->type );
 	type = exprType.lastType();
 	}
@@ -1042,4 +1125,9 @@ ClassMemberDeclaration::AccessPolicy DeclarationBuilder::accessPolicyFromLastMod
 	}
 }
 
+void DeclarationBuilder::addToClassIndex( ClassDeclaration *declaration ){
+	DUChainReadLocker lock;
+	ClassIndex::self().add( declaration );
+}
+
 }
@@ -46,6 +46,14 @@ public:
 	/** Get documentation for node. */
 	QString getDocumentationForNode( const AstNode &node ) const;
 	
+	/**
+	 * Build declarations of function \p node in place. The rest of \p top is left
+	 * untouched. Requires the function to be located at the same position as during
+	 * the last build. Returns false if the function could not be rebuilt in place.
+	 */
+	bool buildFunction( const ReferencedTopDUContext &top, StartAst *start,
+		ClassBodyDeclarationAst *node );
+	
     void visitStart( StartAst *node ) override;
 	void visitScript( ScriptAst *node ) override;
     void visitScriptDeclaration( ScriptDeclarationAst *node ) override;
@@ -78,6 +86,9 @@ public:
 protected:
 	/** Access policy from last modifiers. */
 	ClassMemberDeclaration::AccessPolicy accessPolicyFromLastModifiers() const;
+	
+	/** Add class declaration to global class index. */
+	void addToClassIndex( ClassDeclaration *declaration );
 };
 
 }
@@ -1,5 +1,8 @@
-#include <QMutexLocker>
 #include <QDebug>
+#include <QTimer>
+#include <QCoreApplication>
+
+#include <algorithm>
 
 #include <language/backgroundparser/backgroundparser.h>
 #include <interfaces/icore.h>
@@ -21,7 +24,8 @@ TopDUContext::Features features, int priority, ParseJob::SequentialProcessingFla
 		.features = features,
 		.priority = priority,
 		.flags = flags,
-		.delay = delay
+		.delay = delay,
+		.dependencyDepth = 0
 	} );
 }
 
@@ -33,17 +37,16 @@ const ScheduleParameters &parameters ){
 			qDebug() << "file" << file << "has empty dependencies. schedule now";
 		}
 		
-		ICore::self()->languageController()->backgroundParser()->addDocument( file,
-			parameters.features, parameters.priority, nullptr, parameters.flags, parameters.delay );
+		schedule( file, parameters );
 		return;
 	}
 	
+	Locker lock( *this );
+	
 	// unregister file first
-	cancelWaiting( file );
+	cancelWaitingLocked( file );
 	
 	// create shared data storing the state of the waiting
-	QMutexLocker lock( &pMutex );
-	
 	ScheduleParametersReference state( new ScheduleParameters( parameters ) );
 	state->remainingFileCount = dependencies.size();
 	
@@ -68,45 +71,24 @@ const ScheduleParameters &parameters ){
 // 			qDebug() << "DelayedParsing: waiting for" << file << "on" << *iterFileSet;
 // 		}
 	}
+	
+	pWaitingMap.insert( file, dependencies );
 }
 
 void DelayedParsing::cancelWaiting( const IndexedString &file ){
-	QMutexLocker lock( &pMutex );
-	
-	// iterate over all dependency slots
-	DependencyMap::iterator iterDependency;
-	for( iterDependency = pDependencyMap.begin(); iterDependency != pDependencyMap.end(); iterDependency++ ){
-		// find waiter matching file
-		const WaiterMap::iterator iterWaiter( iterDependency.value().find( file ) );
-		if( iterWaiter == iterDependency.value().end() ){
-			// file not waiting for dependency
-			continue;
-		}
-		
-		// remove file from dependency
-		iterDependency.value().erase( iterWaiter );
-		
-		if( pDebugEnabled ){
-			qDebug() << "DelayedParsing: cancelled waiting for" << file << "on" << iterDependency.key();
-		}
-	}
+	Locker lock( *this );
+	cancelWaitingLocked( file );
 }
 
 bool DelayedParsing::isWaiting( const IndexedString &file ){
-	QMutexLocker lock( &pMutex );
+	Locker lock( *this );
 	
-	DependencyMap::const_iterator iter;
-	for( iter = pDependencyMap.cbegin(); iter != pDependencyMap.cend(); iter++ ){
-		if( iter.value().contains( file ) ){
-			return true;
-		}
-	}
-	
-	return false;
+	// batched files are about to be scheduled and count as waiting until then
+	return pWaitingMap.contains( file ) || pBatch.contains( file );
 }
 
 void DelayedParsing::parsingFinished( const IndexedString &file ){
-	QMutexLocker lock( &pMutex );
+	Locker lock( *this );
 	
 	// find dependency file slot
 	const DependencyMap::iterator iterDependency( pDependencyMap.find( file ) );
@@ -123,52 +105,225 @@ void DelayedParsing::parsingFinished( const IndexedString &file ){
 	const WaiterMap waiters( *iterDependency );
 	pDependencyMap.erase( iterDependency );
 	
-	// drop the lock in case rescheduling calls back to us
-	lock.unlock();
-	
-	// reschedule all files if they are not already scheduled and have their count reached 0
-	BackgroundParser &backgroundParser = *ICore::self()->languageController()->backgroundParser();
+	// update waiting files and find the ones having their count reached 0
+	WaiterMap ready;
 	WaiterMap::const_iterator iterWaiter;
 	
-	if( pDebugEnabled ){
-		qDebug() << "DelayedParsing: file" << file << "finished parsing. scheduling"
-			<< waiters.size() << "waiters";
-	}
-	
 	for( iterWaiter = waiters.cbegin(); iterWaiter != waiters.cend(); iterWaiter++ ){
+		const WaitingMap::iterator iterWaiting( pWaitingMap.find( iterWaiter.key() ) );
+		if( iterWaiting != pWaitingMap.end() ){
+			iterWaiting->remove( file );
+			if( iterWaiting->isEmpty() ){
+				pWaitingMap.erase( iterWaiting );
+			}
+		}
+		
 		ScheduleParameters &parameters = *iterWaiter->data();
 		parameters.remainingFileCount--;
-		if( parameters.remainingFileCount != 0 ){
-			// not ready yet
-			continue;
+		if( parameters.remainingFileCount == 0 ){
+			ready.insert( iterWaiter.key(), iterWaiter.value() );
 		}
-		
-		if( backgroundParser.isQueued( iterWaiter.key() ) ){
-			// file is already queued for parsing. ignore it
+	}
+	
+	if( pDebugEnabled ){
+		qDebug() << "DelayedParsing: file" << file << "finished parsing." << waiters.size()
+			<< "waiters," << ready.size() << "ready. lock held" << pLockStatistics.count
+			<< "times, total" << ( pLockStatistics.totalHoldTime / 1000 ) << "us, max"
+			<< ( pLockStatistics.maxHoldTime / 1000 ) << "us";
+	}
+	
+	// drop the lock in case rescheduling calls back to us
+	lock.unlock();
+	
+	// reschedule all ready files
+	for( iterWaiter = ready.cbegin(); iterWaiter != ready.cend(); iterWaiter++ ){
+		schedule( iterWaiter.key(), *iterWaiter->data() );
+	}
+}
+
+void DelayedParsing::schedule( const IndexedString &file, const ScheduleParameters &parameters ){
+	if( ! pBatchingEnabled ){
+		BackgroundParser &backgroundParser = *ICore::self()->languageController()->backgroundParser();
+		if( backgroundParser.isQueued( file ) ){
 			if( pDebugEnabled ){
-				qDebug() << "- file already scheduled" << iterWaiter.key();
+				qDebug() << "- file already scheduled" << file;
 			}
-			
-			continue;
+			return;
 		}
 		
-		// schedule the file using the stored parameters
 		if( pDebugEnabled ){
-			qDebug() << "- schedule file" << iterWaiter.key();
+			qDebug() << "- schedule file" << file;
+		}
+		backgroundParser.addDocument( file, parameters.features, parameters.priority,
+			nullptr, parameters.flags, parameters.delay );
+		return;
+	}
+	
+	Locker lock( *this );
+	
+	// merge with batched entry keeping the better priority
+	const QHash<IndexedString, ScheduleParameters>::iterator iter( pBatch.find( file ) );
+	if( iter != pBatch.end() ){
+		iter->features = static_cast<TopDUContext::Features>( iter->features | parameters.features );
+		iter->priority = qMin( iter->priority, parameters.priority );
+		iter->dependencyDepth = qMin( iter->dependencyDepth, parameters.dependencyDepth );
+		iter->delay = qMin( iter->delay, parameters.delay );
+		
+	}else{
+		pBatch.insert( file, parameters );
+	}
+	
+	if( pBatchFlushPending ){
+		return;
+	}
+	pBatchFlushPending = true;
+	
+	// flush on the main thread once the batch window elapsed. job threads have no
+	// event loop running so first hop over to the application thread
+	const int window = pBatchWindow;
+	QMetaObject::invokeMethod( QCoreApplication::instance(), [ window ](){
+		QTimer::singleShot( window, QCoreApplication::instance(), [](){
+			DelayedParsing::self().flushBatch();
+		} );
+	}, Qt::QueuedConnection );
+}
+
+void DelayedParsing::flushBatch(){
+	QHash<IndexedString, ScheduleParameters> batch;
+	{
+	Locker lock( *this );
+	batch.swap( pBatch );
+	pBatchFlushPending = false;
+	}
+	
+	if( batch.isEmpty() ){
+		return;
+	}
+	
+	typedef QPair<IndexedString, ScheduleParameters> Entry;
+	QVector<Entry> entries;
+	entries.reserve( batch.size() );
+	
+	QHash<IndexedString, ScheduleParameters>::const_iterator iterBatch;
+	for( iterBatch = batch.cbegin(); iterBatch != batch.cend(); iterBatch++ ){
+		entries << Entry( iterBatch.key(), iterBatch.value() );
+	}
+	
+	std::sort( entries.begin(), entries.end(), []( const Entry &a, const Entry &b ){
+		if( a.second.priority != b.second.priority ){
+			return a.second.priority < b.second.priority;
+		}
+		return a.second.dependencyDepth < b.second.dependencyDepth;
+	} );
+	
+	if( pDebugEnabled ){
+		qDebug() << "DelayedParsing: flush batch scheduling" << entries.size() << "files";
+	}
+	
+	BackgroundParser &backgroundParser = *ICore::self()->languageController()->backgroundParser();
+	foreach( const Entry &entry, entries ){
+		if( backgroundParser.isQueued( entry.first ) ){
+			if( pDebugEnabled ){
+				qDebug() << "- file already scheduled" << entry.first;
+			}
+			continue;
 		}
 		
-		backgroundParser.addDocument( iterWaiter.key(), parameters.features,
-			parameters.priority, nullptr, parameters.flags, parameters.delay );
+		const ScheduleParameters &parameters = entry.second;
+		backgroundParser.addDocument( entry.first, parameters.features, parameters.priority,
+			nullptr, parameters.flags, parameters.delay );
 	}
 }
 
+void DelayedParsing::setBatchingEnabled( bool enabled ){
+	if( pBatchingEnabled.exchange( enabled ) == enabled ){
+		return;
+	}
+	
+	if( ! enabled ){
+		flushBatch();
+	}
+}
+
+void DelayedParsing::setBatchWindow( int window ){
+	pBatchWindow = qMax( window, 0 );
+}
+
 DelayedParsing::DependencyMap DelayedParsing::dependencyMap(){
-	QMutexLocker lock( &pMutex );
+	Locker lock( *this );
 	return pDependencyMap;
 }
 
+DelayedParsing::LockStatistics DelayedParsing::lockStatistics(){
+	QMutexLocker lock( &pMutex );
+	return pLockStatistics;
+}
+
+void DelayedParsing::resetLockStatistics(){
+	QMutexLocker lock( &pMutex );
+	pLockStatistics = {};
+}
+
 void DelayedParsing::setDebugEnabled( bool enabled ){
 	pDebugEnabled = enabled;
 }
 
+
+
+void DelayedParsing::cancelWaitingLocked( const IndexedString &file ){
+	const WaitingMap::iterator iterWaiting( pWaitingMap.find( file ) );
+	if( iterWaiting == pWaitingMap.end() ){
+		return;
+	}
+	
+	// remove file only from the dependency slots it is waiting on
+	const FileSet dependencies( *iterWaiting );
+	pWaitingMap.erase( iterWaiting );
+	
+	foreach( const IndexedString &dependency, dependencies ){
+		const DependencyMap::iterator iterDependency( pDependencyMap.find( dependency ) );
+		if( iterDependency == pDependencyMap.end() ){
+			continue;
+		}
+		
+		iterDependency->remove( file );
+		if( iterDependency->isEmpty() ){
+			pDependencyMap.erase( iterDependency );
+		}
+		
+		if( pDebugEnabled ){
+			qDebug() << "DelayedParsing: cancelled waiting for" << file << "on" << dependency;
+		}
+	}
+}
+
+
+
+DelayedParsing::Locker::Locker( DelayedParsing &owner ) :
+pOwner( owner ),
+pLock( &owner.pMutex ),
+pLocked( true )
+{
+	pTimer.start();
+}
+
+DelayedParsing::Locker::~Locker(){
+	unlock();
+}
+
+void DelayedParsing::Locker::unlock(){
+	if( ! pLocked ){
+		return;
+	}
+	
+	const qint64 elapsed = pTimer.nsecsElapsed();
+	LockStatistics &statistics = pOwner.pLockStatistics;
+	statistics.count++;
+	statistics.totalHoldTime += elapsed;
+	statistics.maxHoldTime = qMax( statistics.maxHoldTime, elapsed );
+	
+	pLocked = false;
+	pLock.unlock();
+}
+
 }
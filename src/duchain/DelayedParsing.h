@@ -5,6 +5,10 @@
 #include <QSet>
 #include <QSharedPointer>
 #include <QMutex>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+#include <atomic>
 
 #include <language/backgroundparser/parsejob.h>
 #include <language/interfaces/ilanguagesupport.h>
@@ -38,6 +42,11 @@ namespace DragonScript {
  * If a job aborts it has to remove itself from the DelayedParsing instance by calling
  * \ref cancelWaiting(). Not doing so just causes them to be rescheduled although not needed.
  * 
+ * Files becoming ready are by default not scheduled right away. They are collected for
+ * a short time window and then scheduled in one pass sorted by priority and dependency
+ * depth. This avoids thrashing the background parser with single queue insertions while
+ * packages are imported.
+ * 
  * This class uses an internal locking and is thread safe. No locks need to be held while
  * using this class unless noted.
  */
@@ -71,6 +80,11 @@ public:
 		 * Delay in milliseconds.
 		 */
 		int delay;
+		
+		/**
+		 * Dependency depth of file. Files with lower depth are scheduled first.
+		 */
+		int dependencyDepth;
 	};
 	
 	/**
@@ -93,12 +107,47 @@ public:
 	 */
 	typedef QSet<IndexedString> FileSet;
 	
+	/**
+	 * Waiting map type. Maps waiting file to dependencies it is waiting for.
+	 */
+	typedef QHash<IndexedString, FileSet> WaitingMap;
+	
+	/**
+	 * Lock statistics. Times are in nano-seconds.
+	 */
+	struct LockStatistics{
+		quint64 count;
+		qint64 totalHoldTime;
+		qint64 maxHoldTime;
+	};
+	
 	
 	
 	
 private:
+	/** Mutex locker recording lock hold time. */
+	class Locker{
+	public:
+		Locker( DelayedParsing &owner );
+		~Locker();
+		void unlock();
+		
+	private:
+		DelayedParsing &pOwner;
+		QMutexLocker pLock;
+		QElapsedTimer pTimer;
+		bool pLocked;
+	};
+	
 	QMutex pMutex;
 	DependencyMap pDependencyMap;
+	WaitingMap pWaitingMap;
+	LockStatistics pLockStatistics = {};
+	
+	QHash<IndexedString, ScheduleParameters> pBatch;
+	bool pBatchFlushPending = false;
+	std::atomic<bool> pBatchingEnabled{ true };
+	std::atomic<int> pBatchWindow{ 50 };
 	
 	static DelayedParsing pSelf;
 	
@@ -137,7 +186,8 @@ public:
 	void cancelWaiting( const IndexedString &file );
 	
 	/**
-	 * Returns true if \em file is waiting for other files.
+	 * Returns true if \em file is waiting for other files or for the pending batch to be
+	 * scheduled.
 	 */
 	bool isWaiting( const IndexedString &file );
 	
@@ -146,6 +196,37 @@ public:
 	 */
 	void parsingFinished( const IndexedString &file );
 	
+	/**
+	 * Schedule \em file for parsing. If batching is enabled the file is added to the
+	 * batch scheduled once the batch window elapsed.
+	 */
+	void schedule( const IndexedString &file, const ScheduleParameters &parameters );
+	
+	/**
+	 * Schedule all files in the batch right now.
+	 */
+	void flushBatch();
+	
+	/**
+	 * Batching is enabled.
+	 */
+	inline bool batchingEnabled() const{ return pBatchingEnabled; }
+	
+	/**
+	 * Set if batching is enabled. Disabling flushes the batch.
+	 */
+	void setBatchingEnabled( bool enabled );
+	
+	/**
+	 * Batch window in milliseconds.
+	 */
+	inline int batchWindow() const{ return pBatchWindow; }
+	
+	/**
+	 * Set batch window in milliseconds.
+	 */
+	void setBatchWindow( int window );
+	
 	/**
 	 * Debug output is enabled.
 	 */
@@ -162,6 +243,21 @@ public:
 	 * Retrieve copy of dependency map.
 	 */
 	DependencyMap dependencyMap();
+	
+	/**
+	 * Retrieve lock statistics.
+	 */
+	LockStatistics lockStatistics();
+	
+	/**
+	 * Reset lock statistics.
+	 */
+	void resetLockStatistics();
+	
+	
+	
+private:
+	void cancelWaitingLocked( const IndexedString &file );
 };
 
 }
@@ -0,0 +1,64 @@
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include "ExpressionMemo.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+bool ExpressionMemo::find( const AstNode &node, const DUContext *searchContext,
+bool allowVoid, Entry &entry ){
+	{
+	QReadLocker lock( &pLock );
+	// nodes can carry an index from a memo of a previous parse job
+	const int index = node.memoIndex - 1;
+	if( index < 0 || index >= pEntries.size() || pEntries.at( index ).node != &node ){
+		return false;
+	}
+	entry = pEntries.at( index );
+	}
+	
+	if( entry.searchContext != searchContext || entry.allowVoid != allowVoid ){
+		return false;
+	}
+	
+	// declarations and contexts can be deleted while the job runs
+	if( ( entry.hasDeclaration && ! entry.declaration ) || ( entry.hasContext && ! entry.context ) ){
+		return false;
+	}
+	
+	return true;
+}
+
+void ExpressionMemo::add( AstNode &node, const DUContext *searchContext, bool allowVoid,
+const AbstractType::Ptr &type, Declaration *declaration, DUContext *context, bool isTypeName ){
+	Entry entry;
+	entry.node = &node;
+	entry.searchContext = searchContext;
+	entry.allowVoid = allowVoid;
+	entry.type = type;
+	entry.declaration = DeclarationPointer( declaration );
+	entry.context = DUContextPointer( context );
+	entry.hasDeclaration = declaration != nullptr;
+	entry.hasContext = context != nullptr;
+	entry.isTypeName = isTypeName;
+	
+	QWriteLocker lock( &pLock );
+	const int index = node.memoIndex - 1;
+	if( index >= 0 && index < pEntries.size() && pEntries.at( index ).node == &node ){
+		pEntries[ index ] = entry;
+		
+	}else{
+		pEntries << entry;
+		node.memoIndex = pEntries.size();
+	}
+}
+
+void ExpressionMemo::clear(){
+	QWriteLocker lock( &pLock );
+	pEntries.clear();
+}
+
+}
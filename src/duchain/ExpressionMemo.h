@@ -0,0 +1,72 @@
+#ifndef EXPRESSIONMEMO_H
+#define EXPRESSIONMEMO_H
+
+#include <language/duchain/duchainpointer.h>
+#include <language/duchain/ducontext.h>
+#include <language/duchain/types/abstracttype.h>
+
+#include <QReadWriteLock>
+#include <QVector>
+
+#include "dsp_ast.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+/**
+ * Memo of resolved type names.
+ *
+ * Type names are resolved by the declaration builder for declarations and again by the
+ * use builder and expression visitors while building uses. The memo stores the result
+ * per AST node so the same type name is resolved once per parse job. Nodes store the
+ * index of their entry in the memoIndex extra AST member next to ducontext.
+ *
+ * Entries are only used if the node is resolved in the same context with the same void
+ * handling and the resolved declaration and context still exist.
+ *
+ * One memo is used per parse job. The class is thread safe.
+ */
+class ExpressionMemo{
+public:
+	/** Memoized result. */
+	struct Entry{
+		const AstNode *node;
+		const DUContext *searchContext;
+		bool allowVoid;
+		AbstractType::Ptr type;
+		DeclarationPointer declaration;
+		DUContextPointer context;
+		bool hasDeclaration;
+		bool hasContext;
+		bool isTypeName;
+	};
+	
+	
+	
+	ExpressionMemo() = default;
+	
+	/**
+	 * Find entry for node resolved in search context. Returns false if absent or invalid.
+	 * \note DUChainReadLocker required.
+	 */
+	bool find( const AstNode &node, const DUContext *searchContext, bool allowVoid, Entry &entry );
+	
+	/** Add entry replacing the previous entry of the node if present. */
+	void add( AstNode &node, const DUContext *searchContext, bool allowVoid,
+		const AbstractType::Ptr &type, Declaration *declaration, DUContext *context, bool isTypeName );
+	
+	/** Clear memo. */
+	void clear();
+	
+	
+	
+private:
+	QReadWriteLock pLock;
+	QVector<Entry> pEntries;
+};
+
+}
+
+#endif
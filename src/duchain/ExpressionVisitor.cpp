@@ -48,6 +48,10 @@ void ExpressionVisitor::setAllowVoid( bool allowVoid ){
 	pAllowVoid = allowVoid;
 }
 
+void ExpressionVisitor::setExpressionMemo( ExpressionMemo *memo ){
+	pExpressionMemo = memo;
+}
+
 bool ExpressionVisitor::isLastAlias() const{
 	Declaration * const d = m_lastDeclaration.data();
 	return d && ( dynamic_cast<AliasDeclaration*>( d ) || dynamic_cast<ClassDeclaration*>( d ) );
@@ -114,6 +118,27 @@ void ExpressionVisitor::visitFullyQualifiedClassname( FullyQualifiedClassnameAst
 		return;
 	}
 	
+	// type names are resolved by multiple builders. unknown name reporting requires
+	// resolving the name to find the unknown names
+	if( ! pExpressionMemo || m_reportUnknownNames ){
+		resolveFullyQualifiedClassname( node );
+		return;
+	}
+	
+	ExpressionMemo::Entry entry;
+	if( pExpressionMemo->find( *node, m_context, pAllowVoid, entry ) ){
+		encounter( entry.type, entry.declaration );
+		pLastContext = entry.context.data();
+		pIsTypeName = entry.isTypeName;
+		return;
+	}
+	
+	resolveFullyQualifiedClassname( node );
+	pExpressionMemo->add( *node, m_context, pAllowVoid, m_lastType,
+		m_lastDeclaration.data(), pLastContext, pIsTypeName );
+}
+
+void ExpressionVisitor::resolveFullyQualifiedClassname( FullyQualifiedClassnameAst *node ){
 	const KDevPG::ListNode<IdentifierAst*> *iter = node->nameSequence->front();
 	const KDevPG::ListNode<IdentifierAst*> *end = iter;
 	const DUContext *searchContext = m_context;
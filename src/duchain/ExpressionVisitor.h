@@ -22,6 +22,7 @@
 #include "Helpers.h"
 #include "TypeFinder.h"
 #include "Namespace.h"
+#include "ExpressionMemo.h"
 
 
 using namespace KDevelop;
@@ -59,6 +60,8 @@ private:
 	const QVector<Namespace*> &pSearchNamespaces;
 	Namespace &pRootNamespace;
 	
+	ExpressionMemo *pExpressionMemo = nullptr;
+	
 	
 	
 public:
@@ -95,6 +98,12 @@ public:
 	/** \brief Set if void type is allowed. */
 	void setAllowVoid( bool allowVoid );
 	
+	/** \brief Memo of resolved type names or nullptr. */
+	inline ExpressionMemo *getExpressionMemo() const{ return pExpressionMemo; }
+	
+	/** \brief Set memo of resolved type names or nullptr. */
+	void setExpressionMemo( ExpressionMemo *memo );
+	
 	void enableUnknownNameReporting(){
 		m_reportUnknownNames = true;
 	}
@@ -125,6 +134,9 @@ protected:
 	void encounterInternalType( ClassDeclaration *classDecl );
 	void encounterFunction( ClassFunctionDeclaration *funcDecl );
 	
+	/** \brief Resolve type name. */
+	void resolveFullyQualifiedClassname( FullyQualifiedClassnameAst *node );
+	
 	/** \brief Check function call. */
 	void checkFunctionCall( AstNode &node, const DUContext &context,
 		const AbstractType::Ptr &argument, bool staticOnly = false );
@@ -35,6 +35,9 @@
 #include "ExpressionVisitor.h"
 #include "ImportPackageLanguage.h"
 #include "TypeFinder.h"
+#include "MemberTableCache.h"
+#include "CastableCache.h"
+#include "../DSParseJob.h"
 
 
 using namespace KDevelop;
@@ -161,6 +164,13 @@ bool Helpers::equalsInternal( const AbstractType::Ptr &type, const QualifiedIden
 
 bool Helpers::castable( const AbstractType::Ptr &type, const AbstractType::Ptr &targetType,
 TypeFinder &typeFinder ){
+	QSet<uint> topContexts;
+	bool complete = true;
+	return castableInHierarchy( type, targetType, typeFinder, topContexts, complete );
+}
+
+bool Helpers::castableInHierarchy( const AbstractType::Ptr &type, const AbstractType::Ptr &targetType,
+TypeFinder &typeFinder, QSet<uint> &topContexts, bool &complete ){
 	// NOTE pTypeInvalid is considered a wildcard to reduce errors shown to meaningful ones
 	if( type == pTypeInvalid || targetType == pTypeInvalid ){
 		return true;
@@ -180,22 +190,59 @@ TypeFinder &typeFinder ){
 		return true;
 	}
 	
+	// the result is cached per type pair until a visited class is rebuilt
+	const IndexedType indexedType( type );
+	const IndexedType indexedTargetType( targetType );
+	QSet<uint> resultTopContexts;
+	bool result;
+	
+	if( CastableCache::self().castable( indexedType, indexedTargetType, typeFinder, result, resultTopContexts ) ){
+		topContexts.unite( resultTopContexts );
+		return result;
+	}
+	
+	bool resultComplete = true;
+	result = castableUncached( type, targetType, typeFinder, resultTopContexts, resultComplete );
+	
+	// results depending on unresolved classes or classes without declared base classes
+	// are not cached since no rebuild drops them once the classes are complete
+	if( resultComplete ){
+		CastableCache::self().add( indexedType, indexedTargetType, result, resultTopContexts );
+		
+	}else{
+		complete = false;
+	}
+	
+	topContexts.unite( resultTopContexts );
+	return result;
+}
+
+bool Helpers::castableUncached( const AbstractType::Ptr &type, const AbstractType::Ptr &targetType,
+TypeFinder &typeFinder, QSet<uint> &topContexts, bool &complete ){
 	// test against supper class and interfaces of type1
 	ClassDeclaration * const classDecl = typeFinder.declarationFor( type );
 	if( ! classDecl ){
+		complete = false;
 		return false;
 	}
 	
-	ClassDeclaration * const superClassDecl = superClassOf( *classDecl, typeFinder );
-	if( superClassDecl ){
-		if( castable( superClassDecl->abstractType(), targetType, typeFinder ) ){
-			return true;
-		}
+	const TopDUContext * const top = classDecl->topContext();
+	topContexts << top->ownIndex();
+	if( DSParseJob::phaseFromFlags( top->features() ) < 2 ){
+		complete = false; // base classes are not declared yet
 	}
 	
-	const QVector<ClassDeclaration*> implements( implementsOf( *classDecl, typeFinder ) );
-	foreach( ClassDeclaration* implement, implements ){
-		if( castable( implement->abstractType(), targetType, typeFinder ) ){
+	uint i;
+	for( i=0; i<classDecl->baseClassesSize(); i++ ){
+		// first base class is the super class. others are implemented interfaces
+		ClassDeclaration * const baseDecl = typeFinder.declarationFor(
+			classDecl->baseClasses()[ i ].baseClass.abstractType() );
+		if( ! baseDecl ){
+			complete = false;
+			continue;
+		}
+		
+		if( castableInHierarchy( baseDecl->abstractType(), targetType, typeFinder, topContexts, complete ) ){
 			return true;
 		}
 	}
@@ -788,103 +835,178 @@ QVector<QPair<Declaration*, int>> Helpers::allDeclarationsInBase( const DUContex
 		return declarations;
 	}
 	
+	// the flattened table is cached until a class in the hierarchy is rebuilt
+	if( MemberTableCache::self().members( *classDecl, typeFinder, declarations ) ){
+		return declarations;
+	}
+	
+	QSet<uint> topContexts;
+	topContexts << classDecl->topContext()->ownIndex();
+	const bool complete = collectDeclarationsInBase( *classDecl, 0, typeFinder, declarations, topContexts );
+	
+	// base class constructors are never visible in the class and are dropped too
+	declarations = consolidate( declarations, context );
+	
+	// incomplete hierarchies are not cached since no rebuild drops the table once the
+	// missing class appears. this includes classes of lazy package files not parsed yet
+	if( complete ){
+		MemberTableCache::self().add( *classDecl, declarations, topContexts );
+	}
+	
+	return declarations;
+}
+
+bool Helpers::collectDeclarationsInBase( const ClassDeclaration &declaration, int depth,
+TypeFinder &typeFinder, QVector<QPair<Declaration*, int>> &declarations, QSet<uint> &topContexts ){
+	bool complete = true;
 	uint i;
-	for( i=0; i<classDecl->baseClassesSize(); i++ ){
-		DUContext * const baseContext = typeFinder.contextFor(
-			classDecl->baseClasses()[ i ].baseClass.abstractType() );
+	
+	for( i=0; i<declaration.baseClassesSize(); i++ ){
+		const ClassDeclaration * const baseDecl = typeFinder.declarationFor(
+			declaration.baseClasses()[ i ].baseClass.abstractType() );
+		DUContext * const baseContext = baseDecl ? baseDecl->internalContext() : nullptr;
 		if( ! baseContext ){
+			complete = false;
 			continue;
 		}
 		
+		const TopDUContext * const baseTop = baseDecl->topContext();
+		topContexts << baseTop->ownIndex();
+		if( DSParseJob::phaseFromFlags( baseTop->features() ) < 2 ){
+			complete = false; // members are not declared yet
+		}
+		
 		const QVector<Declaration*> foundDeclarations( baseContext->localDeclarations() );
 		foreach( Declaration *each, foundDeclarations ){
-			declarations << QPair<Declaration*, int>{ each, 0 };
+			declarations << QPair<Declaration*, int>{ each, depth };
 		}
 		
-		const QVector<QPair<Declaration*, int>> declList( allDeclarationsInBase( *baseContext, typeFinder ) );
-		foreach( auto each, declList ){
-			declarations << QPair<Declaration*, int>{ each.first, each.second + 1 };
+		if( ! collectDeclarationsInBase( *baseDecl, depth + 1, typeFinder, declarations, topContexts ) ){
+			complete = false;
 		}
 	}
 	
-	return declarations;
+	return complete;
 }
 
 QVector<QPair<Declaration*, int>> Helpers::consolidate(
 const QVector<QPair<Declaration*, int>> &list, const DUContext &context ){
-	QVector<QPair<Declaration*, int>> result;
+	// accepted declarations are indexed by identifier and by function signature. the
+	// first accepted declaration matching a found one is located using these instead
+	// of comparing against all accepted declarations. entries are never moved so the
+	// entry order is the result order. replaced entries are only marked removed
+	struct Entry{
+		QPair<Declaration*, int> declaration;
+		QList<AbstractType::Ptr> arguments;
+		uint signature;
+		bool function;
+		bool removed;
+	};
+	
+	QVector<Entry> entries;
+	QHash<IndexedIdentifier, QVector<int>> identifierEntries;
+	QHash<uint, QVector<int>> signatureEntries;
+	entries.reserve( list.size() );
 	
 	foreach( auto foundDecl, list ){
 		const TypePtr<FunctionType> foundFunc = foundDecl.first->type<FunctionType>();
-		bool include = true;
+		const IndexedIdentifier &identifier = foundDecl.first->indexedIdentifier();
 		
 		// constructors work a bit different. only the constructors functions matching
 		// the provided context are kept. base class constructors are all removed
-		if( foundFunc && foundDecl.first->indexedIdentifier() == nameConstructor()
-		&& foundDecl.first->context() != &context ){
+		if( foundFunc && identifier == nameConstructor() && foundDecl.first->context() != &context ){
 			continue;
 		}
 		
-		QVector<QPair<Declaration*, int>>::iterator iter;
-		for( iter = result.begin(); iter != result.end(); iter++ ){
-			// functions can be duplicated because interfaces are base class Object too
-			if( foundDecl.first == iter->first ){
-				include = false;
-				break;
+		QList<AbstractType::Ptr> arguments;
+		uint signature = 0;
+		int match = -1;
+		
+		if( foundFunc ){
+			// unfortunately we can not use FunctionType->equals() since this also
+			// checks the return type. in DS though functions are equal if their
+			// arguments are equal disregarding the return type. functions only match
+			// functions with the same identifier and arguments. there is at most one
+			// such accepted function
+			arguments = foundFunc->arguments();
+			signature = signatureHash( identifier, arguments );
+			
+			foreach( int index, signatureEntries.value( signature ) ){
+				const Entry &entry = entries.at( index );
+				if( entry.declaration.first->indexedIdentifier() == identifier
+				&& sameArguments( arguments, entry.arguments ) ){
+					match = index;
+					break;
+				}
 			}
 			
-			if( foundDecl.first->indexedIdentifier() != iter->first->indexedIdentifier() ){
-				continue;
+		}else{
+			// other declarations match the first accepted declaration with the same identifier
+			const QVector<int> &candidates = identifierEntries[ identifier ];
+			if( ! candidates.isEmpty() ){
+				match = candidates.first();
 			}
+		}
+		
+		if( match != -1 ){
+			Entry &entry = entries[ match ];
 			
-			if( foundFunc ){
-				// unfortunately we can not use FunctionType->equals() since this also
-				// checks the return type. in DS though functions are equal if their
-				// arguments are equal disregarding the return type
-				/*if( ! foundFunc->equals( iter->first->abstractType().data() ) ){
-					continue;
-				}*/
-				const TypePtr<FunctionType> checkFunc = iter->first->type<FunctionType>();
-				if( ! checkFunc ){
-					continue;
-				}
-				
-				const QList<AbstractType::Ptr> args1( foundFunc->arguments() );
-				const QList<AbstractType::Ptr> args2( checkFunc->arguments() );
-				if( args1.size() != args2.size() ){
-					continue;
-				}
-				
-				QList<AbstractType::Ptr>::const_iterator iter1, iter2;
-				for( iter1 = args1.constBegin(), iter2 = args2.constBegin(); iter1 != args1.constEnd(); iter1++, iter2++ ){
-					if( ! iter1->data()->equals( iter2->data() ) ){
-						break;
-					}
-				}
-				
-				if( iter1 != args1.constEnd() ){
-					continue;
-				}
+			// functions can be duplicated because interfaces are base class Object too
+			if( foundDecl.first == entry.declaration.first
+			|| foundDecl.second >= entry.declaration.second ){
+				continue;
 			}
 			
-			if( foundDecl.second >= iter->second ){
-				include = false;
-				break;
-				
-			}else{
-				result.erase( iter );
-				break;
+			entry.removed = true;
+			identifierEntries[ identifier ].removeOne( match );
+			if( entry.function ){
+				signatureEntries[ entry.signature ].removeOne( match );
 			}
 		}
 		
-		if( include ){
-			result << foundDecl;
+		const int index = entries.size();
+		entries << Entry{ foundDecl, arguments, signature, bool( foundFunc ), false };
+		identifierEntries[ identifier ] << index;
+		if( foundFunc ){
+			signatureEntries[ signature ] << index;
+		}
+	}
+	
+	QVector<QPair<Declaration*, int>> result;
+	result.reserve( entries.size() );
+	foreach( const Entry &entry, entries ){
+		if( ! entry.removed ){
+			result << entry.declaration;
 		}
 	}
 	
 	return result;
 }
 
+uint Helpers::signatureHash( const IndexedIdentifier &identifier, const QList<AbstractType::Ptr> &arguments ){
+	uint hash = qHash( identifier );
+	foreach( const AbstractType::Ptr &argument, arguments ){
+		hash = hash * 31 + ( argument ? argument->hash() : 0 );
+	}
+	return hash;
+}
+
+bool Helpers::sameArguments( const QList<AbstractType::Ptr> &arguments1,
+const QList<AbstractType::Ptr> &arguments2 ){
+	if( arguments1.size() != arguments2.size() ){
+		return false;
+	}
+	
+	QList<AbstractType::Ptr>::const_iterator iter1, iter2;
+	for( iter1 = arguments1.constBegin(), iter2 = arguments2.constBegin(); iter1 != arguments1.constEnd(); iter1++, iter2++ ){
+		if( ! iter1->data()->equals( iter2->data() ) ){
+			return false;
+		}
+	}
+	
+	return true;
+}
+
 
 
 QVector<Declaration*> Helpers::constructorsInClass( const DUContext &context ){
@@ -904,55 +1026,52 @@ QVector<Declaration*> Helpers::constructorsInClass( const DUContext &context ){
 
 ClassFunctionDeclaration *Helpers::bestMatchingFunction(
 const QVector<AbstractType::Ptr> &signature, const QVector<Declaration*> &declarations ){
-	ClassFunctionDeclaration *bestMatchingDecl = nullptr;
+	return bestMatchingFunction( signature, candidatesFor( signature.size(), declarations ) );
+}
+
+ClassFunctionDeclaration *Helpers::bestMatchingFunction(
+const QVector<AbstractType::Ptr> &signature, const OverloadIndex::CandidateList &candidates ){
 	const int argCount = signature.size();
 	int i;
 	
-	foreach( Declaration* declaration, declarations ){
-		ClassFunctionDeclaration * const funcDecl = dynamic_cast<ClassFunctionDeclaration*>( declaration );
-		if( ! funcDecl ){
-			continue;
-		}
-		
-		const FunctionType::Ptr funcType = funcDecl->type<FunctionType>();
-		if( funcType->arguments().size() != argCount ){
+	foreach( const OverloadIndex::Candidate &candidate, candidates ){
+		if( candidate.arguments.size() != argCount ){
 			continue;
 		}
 		
 		for( i=0; i<argCount; i++ ){
-			if( ! equals( signature.at( i ), funcType->arguments().at( i ) ) ){
+			if( ! equals( signature.at( i ), candidate.arguments.at( i ) ) ){
 				break;
 			}
 		}
 		if( i == argCount ){
-			bestMatchingDecl = funcDecl;
-			break;
+			return candidate.declaration;
 		}
 	}
 	
-	return bestMatchingDecl;
+	return nullptr;
 }
 
 QVector<ClassFunctionDeclaration*> Helpers::autoCastableFunctions(
 const QVector<AbstractType::Ptr> &signature, const QVector<Declaration*> &declarations,
+TypeFinder &typeFinder ){
+	return autoCastableFunctions( signature, candidatesFor( signature.size(), declarations ), typeFinder );
+}
+
+QVector<ClassFunctionDeclaration*> Helpers::autoCastableFunctions(
+const QVector<AbstractType::Ptr> &signature, const OverloadIndex::CandidateList &candidates,
 TypeFinder &typeFinder ){
 	QVector<ClassFunctionDeclaration*> possibleFunctions;
 	const int argCount = signature.size();
 	int i;
 	
-	foreach( Declaration *declaration, declarations ){
-		ClassFunctionDeclaration * const funcDecl = dynamic_cast<ClassFunctionDeclaration*>( declaration );
-		if( ! funcDecl ){
-			continue;
-		}
-		
-		const FunctionType::Ptr funcType = funcDecl->type<FunctionType>();
-		if( funcType->arguments().size() != argCount ){
+	foreach( const OverloadIndex::Candidate &candidate, candidates ){
+		if( candidate.arguments.size() != argCount ){
 			continue;
 		}
 		
 		for( i=0; i<argCount; i++ ){
-			if( ! castable( signature.at( i ), funcType->arguments().at( i ), typeFinder ) ){
+			if( ! castable( signature.at( i ), candidate.arguments.at( i ), typeFinder ) ){
 				break;
 			}
 		}
@@ -963,10 +1082,12 @@ TypeFinder &typeFinder ){
 		// this function could be identical in signature to another one found so far.
 		// if this is the case and the already found function is a reimplmentation
 		// of this function then ignore this function
+		ClassFunctionDeclaration * const funcDecl = candidate.declaration;
+		const FunctionType::Ptr funcType = funcDecl->type<FunctionType>();
 		bool ignoreFunction = false;
 		foreach( const ClassFunctionDeclaration *checkFuncDecl, possibleFunctions ){
 			// if this is a constructor call do not check the return type
-			if( pNameConstructor == declaration->identifier() ){
+			if( pNameConstructor == funcDecl->identifier() ){
 				if( sameSignatureAnyReturnType( funcType, checkFuncDecl->type<FunctionType>() )
 				&& overrides( checkFuncDecl, funcDecl, typeFinder ) ){
 					ignoreFunction = true;
@@ -992,4 +1113,25 @@ TypeFinder &typeFinder ){
 	return possibleFunctions;
 }
 
+OverloadIndex::CandidateList Helpers::candidatesFor( int argumentCount,
+const QVector<Declaration*> &declarations ){
+	OverloadIndex::CandidateList candidates;
+	
+	foreach( Declaration *declaration, declarations ){
+		ClassFunctionDeclaration * const funcDecl = dynamic_cast<ClassFunctionDeclaration*>( declaration );
+		if( ! funcDecl ){
+			continue;
+		}
+		
+		const FunctionType::Ptr funcType = funcDecl->type<FunctionType>();
+		if( ! funcType || funcType->arguments().size() != argumentCount ){
+			continue;
+		}
+		
+		candidates << OverloadIndex::Candidate{ funcDecl, funcType->arguments().toVector() };
+	}
+	
+	return candidates;
+}
+
 }
@@ -13,6 +13,7 @@
 #include <language/duchain/types/unsuretype.h>
 
 #include <QList>
+#include <QSet>
 #include <QSharedPointer>
 
 #include <functional>
@@ -21,6 +22,7 @@
 #include "dsp_ast.h"
 #include "ImportPackage.h"
 #include "Namespace.h"
+#include "OverloadIndex.h"
 
 
 using namespace KDevelop;
@@ -139,7 +141,8 @@ public:
 	static bool equalsInternal( const AbstractType::Ptr &type, const QualifiedIdentifier &internal );
 	
 	/**
-	 * Type is castable to another.
+	 * Type is castable to another. Results are cached per type pair until a class visited
+	 * while testing is rebuilt.
 	 * \note DUChainReadLocker required.
 	 */
 	static bool castable( const AbstractType::Ptr &type, const AbstractType::Ptr &targetType,
@@ -224,14 +227,16 @@ public:
 		TypeFinder &typeFinder, Namespace &rootNamespace, bool withGlobal );
 	
 	/**
-	 * Find all declarations in base classes only.
+	 * Find all declarations in base classes only. The list is consolidated and cached
+	 * per class until a class in the hierarchy is rebuilt.
 	 * \note DUChainReadLocker required.
 	 **/
 	static QVector<QPair<Declaration*, int>> allDeclarationsInBase( const DUContext &context,
 		TypeFinder &typeFinder );
 	
 	/**
-	 * Consolidate found declarations removing overridden members.
+	 * Consolidate found declarations removing overridden members. Runs in linear time
+	 * using hashes of identifiers and function signatures.
 	 */
 	static QVector<QPair<Declaration*, int>> consolidate(
 		const QVector<QPair<Declaration*, int>> &list, const DUContext &context );
@@ -250,6 +255,9 @@ public:
 	static ClassFunctionDeclaration *bestMatchingFunction(
 		const QVector<AbstractType::Ptr> &signature, const QVector<Declaration*> &declarations );
 	
+	static ClassFunctionDeclaration *bestMatchingFunction(
+		const QVector<AbstractType::Ptr> &signature, const OverloadIndex::CandidateList &candidates );
+	
 	/**
 	 * Find suitable functions requiring auto-casting.
 	 * 
@@ -261,6 +269,49 @@ public:
 	static QVector<ClassFunctionDeclaration*> autoCastableFunctions(
 		const QVector<AbstractType::Ptr> &signature, const QVector<Declaration*> &declarations,
 		TypeFinder &typeFinder );
+	
+	static QVector<ClassFunctionDeclaration*> autoCastableFunctions(
+		const QVector<AbstractType::Ptr> &signature, const OverloadIndex::CandidateList &candidates,
+		TypeFinder &typeFinder );
+	
+	
+	
+private:
+	/**
+	 * Castable testing cached results. Adds top contexts of visited classes. Sets
+	 * \em complete to false if a visited class is unresolved or not fully declared.
+	 * \note DUChainReadLocker required.
+	 */
+	static bool castableInHierarchy( const AbstractType::Ptr &type, const AbstractType::Ptr &targetType,
+		TypeFinder &typeFinder, QSet<uint> &topContexts, bool &complete );
+	
+	/**
+	 * Castable testing super class and interfaces without looking up the cache.
+	 * \note DUChainReadLocker required.
+	 */
+	static bool castableUncached( const AbstractType::Ptr &type, const AbstractType::Ptr &targetType,
+		TypeFinder &typeFinder, QSet<uint> &topContexts, bool &complete );
+	
+	/** Hash of function identifier and argument types disregarding the return type. */
+	static uint signatureHash( const IndexedIdentifier &identifier,
+		const QList<AbstractType::Ptr> &arguments );
+	
+	/** Functions with argument count in declarations with extracted argument types. */
+	static OverloadIndex::CandidateList candidatesFor( int argumentCount,
+		const QVector<Declaration*> &declarations );
+	
+	/** Argument types are equal. */
+	static bool sameArguments( const QList<AbstractType::Ptr> &arguments1,
+		const QList<AbstractType::Ptr> &arguments2 );
+	
+	/**
+	 * Add declarations of base classes recursively. Returns false if a base class could
+	 * not be resolved or is not fully declared yet.
+	 * \note DUChainReadLocker required.
+	 */
+	static bool collectDeclarationsInBase( const ClassDeclaration &declaration, int depth,
+		TypeFinder &typeFinder, QVector<QPair<Declaration*, int>> &declarations,
+		QSet<uint> &topContexts );
 };
 
 }
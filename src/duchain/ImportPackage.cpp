@@ -1,4 +1,7 @@
 #include <QPair>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QMutexLocker>
 #include <QDebug>
 
 #include <language/duchain/duchain.h>
@@ -13,7 +16,9 @@
 
 #include "ImportPackage.h"
 #include "DelayedParsing.h"
+#include "ImportPackages.h"
 #include "../DSParseJob.h"
+#include "../DSLanguageSupport.h"
 
 
 using namespace KDevelop;
@@ -21,23 +26,40 @@ using namespace KDevelop;
 namespace DragonScript {
 
 ImportPackage::ImportPackage() :
+pPhaseBarrier( new PhaseBarrier ),
+pLazy( false ),
 pDebug( false ){
 }
 
 ImportPackage::ImportPackage( const QString &name, const QSet<IndexedString> &files ) :
 pName( name ),
 pFiles( files ),
+pPhaseBarrier( new PhaseBarrier ),
+pLazy( false ),
 pDebug( false ){
+	pPhaseBarrier->setFiles( pFiles );
 }
 
 ImportPackage::~ImportPackage(){
+	if( pManifest ){
+		pManifest->setChangedCallback( nullptr );
+	}
+}
+
+QSet<IndexedString> ImportPackage::files() const{
+	QReadLocker lock( &pFilesLock );
+	return pFiles;
 }
 
 void ImportPackage::contexts( State &state, int minRequiredPhase ){
 	minRequiredPhase = qMin( qMax( minRequiredPhase, 1 ), 3 );
 	
-	BackgroundParser &bp = *ICore::self()->languageController()->backgroundParser();
-	DUChain &duchain = *DUChain::self();
+	// lazy packages are usable once all files are skimmed. files declaring classes
+	// referenced by dependent files are requested to be fully parsed by the parse jobs
+	if( pLazy ){
+		minRequiredPhase = 1;
+	}
+	
 	state.ready = true;
 	state.reparsePriority = 0;
 	state.importContexts.clear();
@@ -53,7 +75,146 @@ void ImportPackage::contexts( State &state, int minRequiredPhase ){
 	// phases are always run through from 1 to 3 no matter if something can not be
 	// resolved. this ensures no deadloops can happen nor possible resolves are missed.
 	// we get a finished context after each phase is completed
-	foreach( const IndexedString &file, pFiles ){
+	// 
+	// the phase barrier knows the phase files finished. only files below the required
+	// phase have to be examined. loaded contexts can be ahead of the barrier if they have
+	// been parsed before the barrier knew about them. the barrier is updated in this case
+	QSet<IndexedString> missing;
+	if( ! pPhaseBarrier->reached( minRequiredPhase, IndexedString(), &missing ) ){
+		checkFiles( state, missing, minRequiredPhase, true );
+		if( ! state.ready ){
+			state.importContexts.clear();
+			return;
+		}
+		state.importContexts.clear();
+	}
+	
+	// all files reached the required phase. use the cached contexts if no file changed
+	const quint64 generation = pPhaseBarrier->generation();
+	{
+	QMutexLocker lock( &pContextsMutex );
+	if( pContextsGeneration == generation ){
+		// contexts can have been unloaded or deleted since they are not referenced
+		foreach( const IndexedTopDUContext &each, pContexts ){
+			TopDUContext * const context = each.data();
+			if( ! context ){
+				break;
+			}
+			state.importContexts << context;
+		}
+		
+		if( state.importContexts.size() == pContexts.size() ){
+			return;
+		}
+		state.importContexts.clear();
+	}
+	}
+	
+	checkFiles( state, files(), minRequiredPhase, false );
+	if( ! state.ready ){
+		state.importContexts.clear();
+		return;
+	}
+	
+	QMutexLocker lock( &pContextsMutex );
+	pContexts.clear();
+	foreach( TopDUContext *context, state.importContexts ){
+		pContexts << context->indexed();
+	}
+	pContextsGeneration = generation;
+}
+
+QVector<TopDUContext*> ImportPackage::deepAllContexts(){
+	QVector<quint64> generations;
+	deepGenerations( generations );
+	
+	QVector<TopDUContext*> list;
+	
+	{
+	QMutexLocker lock( &pContextsMutex );
+	if( generations == pDeepContextsGenerations ){
+		// contexts can have been unloaded or deleted since they are not referenced
+		foreach( const IndexedTopDUContext &each, pDeepContexts ){
+			TopDUContext * const context = each.data();
+			if( ! context ){
+				break;
+			}
+			list << context;
+		}
+		
+		if( list.size() == pDeepContexts.size() ){
+			return list;
+		}
+		list.clear();
+	}
+	}
+	
+	DUChain &duchain = *DUChain::self();
+	QSet<TopDUContext*> found;
+	
+	foreach( const IndexedString &file, files() ){
+		TopDUContext * const context = duchain.chainForDocument( file );
+		if( context && ! found.contains( context ) ){
+			found << context;
+			list << context;
+		}
+	}
+	
+	foreach( const ImportPackage::Ref &package, pDependsOn ){
+		foreach( TopDUContext *context, package->deepAllContexts() ){
+			if( ! found.contains( context ) ){
+				found << context;
+				list << context;
+			}
+		}
+	}
+	
+	QMutexLocker lock( &pContextsMutex );
+	pDeepContexts.clear();
+	foreach( TopDUContext *context, list ){
+		pDeepContexts << context->indexed();
+	}
+	pDeepContextsGenerations = generations;
+	return list;
+}
+
+int ImportPackage::dependencyDepth() const{
+	// dependencies do not change after construction
+	int depth = pDependencyDepth;
+	if( depth != -1 ){
+		return depth;
+	}
+	
+	depth = 0;
+	foreach( const Ref &each, pDependsOn ){
+		depth = qMax( depth, each->dependencyDepth() + 1 );
+	}
+	
+	pDependencyDepth = depth;
+	return depth;
+}
+
+void ImportPackage::reparse()
+{
+	const QSet<IndexedString> files( pManifest ? pManifest->modifiedFiles() : this->files() );
+	if( pManifest ){
+		qDebug() << "KDevDScript ImportPackage.reparse" << pName << ":" << files.size() << "files modified";
+	}
+	
+	BackgroundParser &backgroundParser = *ICore::self()->languageController()->backgroundParser();
+	foreach( const IndexedString &file, files ){
+		backgroundParser.addDocument( file, TopDUContext::ForceUpdate );
+	}
+}
+
+
+
+void ImportPackage::checkFiles( State &state, const QSet<IndexedString> &files,
+int minRequiredPhase, bool missing ){
+	BackgroundParser &bp = *ICore::self()->languageController()->backgroundParser();
+	DUChain &duchain = *DUChain::self();
+	
+	foreach( const IndexedString &file, files ){
 		TopDUContext * const context = duchain.chainForDocument( file );
 		
 		if( context ){
@@ -63,11 +224,16 @@ void ImportPackage::contexts( State &state, int minRequiredPhase ){
 			}
 			
 			if( phase < minRequiredPhase ){
+				if( ! missing ){
+					// barrier is ahead of the context. bring it back in line
+					pPhaseBarrier->fileFinished( file, phase );
+				}
+				
 // 				qDebug() << "ImportPackage.getContexts" << pName << ": File has context with phase" << phase << ":" << file;
 				if( bp.isQueued( file ) ){
 					state.reparsePriority = qMax( state.reparsePriority, bp.priorityForDocument( file ) );
 					
-				}else if( ! DelayedParsing::self().isWaiting( file ) ){
+				}else if( ! DelayedParsing::self().isWaiting( file ) && ! pPhaseBarrier->isWaiting( file ) ){
 					// not in the right state and neither pending to be parsed nor waiting for
 					// other files. kick the job in the buts to get running again
 					if( pDebug ){
@@ -79,14 +245,16 @@ void ImportPackage::contexts( State &state, int minRequiredPhase ){
 						| DSParseJob::Resheduled
 						| DSParseJob::phaseFlags( phase + 1 );
 					
-					ICore::self()->languageController()->backgroundParser()->addDocument( file,
-						static_cast<TopDUContext::Features>( features ), 0, nullptr,
+					bp.addDocument( file, static_cast<TopDUContext::Features>( features ), 0, nullptr,
 						ParseJob::IgnoresSequentialProcessing, 10 );
 				}
 				state.waitForFiles << file;
 				state.ready = false;
 				
 			}else{
+				if( missing ){
+					pPhaseBarrier->fileFinished( file, phase );
+				}
 				state.importContexts << context;
 			}
 			
@@ -94,49 +262,57 @@ void ImportPackage::contexts( State &state, int minRequiredPhase ){
 			if( pDebug ){
 				qDebug() << "ImportPackage.getContexts" << pName << ": File has no context, parsing it:" << file;
 			}
-			ICore::self()->languageController()->backgroundParser()->addDocument( file, TopDUContext::ForceUpdate );
+			pPhaseBarrier->fileFinished( file, 0 );
+			bp.addDocument( file, TopDUContext::ForceUpdate );
 			state.waitForFiles << file;
 			state.ready = false;
 		}
 	}
-	
-	if( ! state.ready ){
-		state.importContexts.clear();
-	}
 }
 
-QSet<TopDUContext*> ImportPackage::deepAllContexts(){
-	DUChain &duchain = *DUChain::self();
-	QSet<TopDUContext*> list;
-	
-	foreach( const IndexedString &file, pFiles ){
-		TopDUContext * const context = duchain.chainForDocument( file );
-		if( context ){
-			list << context;
-		}
+void ImportPackage::deepGenerations( QVector<quint64> &generations ) const{
+	generations << pPhaseBarrier->generation();
+	foreach( const Ref &each, pDependsOn ){
+		each->deepGenerations( generations );
 	}
-	
-	foreach( const ImportPackage::Ref &package, pDependsOn ){
-		list.unite( package->deepAllContexts() );
+}
+
+void ImportPackage::setFiles( const QSet<IndexedString> &files ){
+	{
+	QWriteLocker lock( &pFilesLock );
+	pFiles = files;
 	}
+	pPhaseBarrier->setFiles( files );
+}
+
+void ImportPackage::initManifest( const QStringList &directories ){
+	pManifest = PackageManifest::create( pName, directories );
+	setFiles( pManifest->files() );
 	
-	return list;
+	pManifest->setChangedCallback( [ this ]( const QSet<IndexedString> &added,
+	const QSet<IndexedString> &removed ){
+		manifestChanged( added, removed );
+	} );
 }
 
-int ImportPackage::dependencyDepth() const{
-	int depth = 0;
+void ImportPackage::manifestChanged( const QSet<IndexedString> &added, const QSet<IndexedString> &removed ){
+	{
+	QWriteLocker lock( &pFilesLock );
+	pFiles.subtract( removed );
+	pFiles.unite( added );
+	}
 	
-	foreach( const Ref &each, pDependsOn ){
-		depth = qMax( depth, each->dependencyDepth() + 1 );
+	DSLanguageSupport::self()->importPackages().packageFilesChanged( pName, added, removed );
+	
+	foreach( const IndexedString &file, removed ){
+		pPhaseBarrier->removeFile( file );
+	}
+	foreach( const IndexedString &file, added ){
+		pPhaseBarrier->addFile( file );
 	}
 	
-	return depth;
-}
-
-void ImportPackage::reparse()
-{
 	BackgroundParser &backgroundParser = *ICore::self()->languageController()->backgroundParser();
-	foreach( const IndexedString &file, pFiles ){
+	foreach( const IndexedString &file, added ){
 		backgroundParser.addDocument( file, TopDUContext::ForceUpdate );
 	}
 }
@@ -4,10 +4,19 @@
 #include <QString>
 #include <QSet>
 #include <QSharedPointer>
+#include <QReadWriteLock>
+#include <QMutex>
+#include <QVector>
+
+#include <atomic>
 
 #include <language/duchain/topducontext.h>
+#include <language/duchain/indexedtopducontext.h>
 #include <serialization/indexedstring.h>
 
+#include "PhaseBarrier.h"
+#include "PackageManifest.h"
+
 
 using namespace KDevelop;
 
@@ -56,7 +65,19 @@ public:
 	/**
 	 * Files included in the package.
 	 */
-	inline const QSet<IndexedString> &files() const{ return pFiles; }
+	QSet<IndexedString> files() const;
+	
+	/**
+	 * Phase barrier tracking the phase files in the package finished.
+	 */
+	inline const PhaseBarrier::Ref &phaseBarrier() const{ return pPhaseBarrier; }
+	
+	/**
+	 * Package is lazy. Files of lazy packages are only skimmed (phase 1) which is enough
+	 * to find the namespaces and classes they declare. Files are fully parsed only if
+	 * classes they declare are referenced by dependent files.
+	 */
+	inline bool lazy() const{ return pLazy; }
 	
 	
 	
@@ -64,14 +85,23 @@ public:
 	 * List of contexts. If package is not fully parsed yet returns empty list. In this case
 	 * cancel the parsing of the document and schedule it again with a low priority.
 	 * 
+	 * Readiness is answered by the phase barrier. Once ready the contexts are cached until
+	 * the phase of a file changes. Cached contexts are stored indexed and resolved on access
+	 * since referencing them would require DUChainWriteLocker.
+	 * 
+	 * For lazy packages files are only required to be skimmed no matter the required phase.
+	 * 
 	 * \note DUChainReadLocker required.
 	 */
 	void contexts( State &state, int minRequiredPhase );
 	
 	/**
-	 * List of all contexts of this package and all dependencies deeply.
+	 * List of all contexts of this package and all dependencies deeply. The list is
+	 * cached indexed until the phase of a file in this package or a dependency changes.
+	 * 
+	 * \note DUChainReadLocker required.
 	 */
-	QSet<TopDUContext*> deepAllContexts();
+	QVector<TopDUContext*> deepAllContexts();
 	
 	/**
 	 * Packages this package depends on.
@@ -80,13 +110,14 @@ public:
 	inline const QSet<Ref> &dependsOn() const{ return pDependsOn; }
 	
 	/**
-	 * Recusrive dependency depth.
+	 * Recusrive dependency depth. Calculated once.
 	 */
 	int dependencyDepth() const;
 	
 	
 	/**
-	 * Reparse files.
+	 * Reparse files. If the package uses a manifest only added or modified files are
+	 * reparsed.
 	 */
 	void reparse();
 	
@@ -95,13 +126,44 @@ public:
 protected:
 	ImportPackage();
 	
+	/** Set files. */
+	void setFiles( const QSet<IndexedString> &files );
+	
+	/** Use manifest of script files in directories to find and track files. */
+	void initManifest( const QStringList &directories );
+	
+	/** Files added or removed in manifest directories. */
+	void manifestChanged( const QSet<IndexedString> &added, const QSet<IndexedString> &removed );
+	
+	/**
+	 * Check phase of files adding contexts of files with required phase. If \em missing
+	 * is true files are known to the barrier to be below the phase.
+	 */
+	void checkFiles( State &state, const QSet<IndexedString> &files, int minRequiredPhase, bool missing );
+	
+	/** Add generation of phase barrier of this package and all dependencies deeply. */
+	void deepGenerations( QVector<quint64> &generations ) const;
+	
 	
 	
 	QString pName;
 	QSet<IndexedString> pFiles;
+	mutable QReadWriteLock pFilesLock;
+	PhaseBarrier::Ref pPhaseBarrier;
+	PackageManifest::Ref pManifest;
+	
+	QMutex pContextsMutex;
+	QVector<IndexedTopDUContext> pContexts;
+	quint64 pContextsGeneration = 0;
+	
+	QVector<IndexedTopDUContext> pDeepContexts;
+	QVector<quint64> pDeepContextsGenerations;
+	
+	mutable std::atomic<int> pDependencyDepth{ -1 };
 	
 	QSet<Ref> pDependsOn;
 	
+	bool pLazy;
 	bool pDebug;
 };
 
@@ -1,4 +1,3 @@
-#include <QDirIterator>
 #include <QDebug>
 
 #include "ImportPackages.h"
@@ -11,16 +10,10 @@ namespace DragonScript {
 
 ImportPackageDirectory::ImportPackageDirectory( const QString &name, const QString &directory ){
 	pName = name;
-	
-	QDirIterator iter( directory, QStringList() << "*.ds", QDir::Files, QDirIterator::Subdirectories );
-	while( iter.hasNext() ){
-		pFiles << IndexedString( iter.next() );
-	}
+	pLazy = true;
 	
 	qDebug() << "KDevDScript ImportPackageDirectory: directory" << directory;
-	foreach( const IndexedString &each, pFiles ){
-		qDebug() << "KDevDScript ImportPackageDirectory: add file" << each;
-	}
+	initManifest( QStringList() << directory );
 }
 
 }
@@ -1,4 +1,3 @@
-#include <QDirIterator>
 #include <QDebug>
 
 #include "ImportPackages.h"
@@ -15,26 +14,14 @@ const QString ImportPackageDragengine::packageName( "#internal#dragengine#dragon
 
 ImportPackageDragengine::ImportPackageDragengine(){
 	pName = packageName;
+	pLazy = true;
 	
 	pDependsOn << ImportPackageLanguage::self();
 	
 	const QString dir( DSSessionSettings::self.pathDragengineUse() );
 	if( ! dir.isEmpty() ){
 		qDebug() << "KDevDScript ImportPackageDragengine dir" << dir;
-		
-		QDirIterator iter( dir + "/scripts", QStringList() << "*.ds", QDir::Files, QDirIterator::Subdirectories );
-		while( iter.hasNext() ){
-			pFiles << IndexedString( iter.next() );
-		}
-		
-		QDirIterator iter2( dir + "/native", QStringList() << "*.ds", QDir::Files, QDirIterator::Subdirectories );
-		while( iter2.hasNext() ){
-			pFiles << IndexedString( iter2.next() );
-		}
-	}
-	
-	foreach( const IndexedString &each, pFiles ){
-		qDebug() << "KDevDScript ImportPackageDragengine: add file" << each;
+		initManifest( QStringList() << dir + "/scripts" << dir + "/native" );
 	}
 }
 
@@ -1,18 +1,29 @@
 #include <QDirIterator>
 #include <QStandardPaths>
+#include <QCoreApplication>
+#include <QFile>
 #include <QDebug>
 
+#include <language/duchain/duchain.h>
+#include <language/duchain/duchainlock.h>
+#include <interfaces/icore.h>
+#include <interfaces/isession.h>
+#include <KF5/KConfigCore/kconfiggroup.h>
+
 #include "ImportPackages.h"
 #include "ImportPackageLanguage.h"
 #include "../DSSessionSettings.h"
 #include "../DSLanguageSupport.h"
+#include "../DSParseJob.h"
 
 
 namespace DragonScript {
 
 const QString ImportPackageLanguage::packageName( "#internal#language#files#" );
 
-ImportPackageLanguage::ImportPackageLanguage(){
+ImportPackageLanguage::ImportPackageLanguage() :
+pSnapshotValid( false )
+{
 	pName = packageName;
 	
 	const QStringList dirs( QStandardPaths::locateAll( QStandardPaths::GenericDataLocation,
@@ -29,6 +40,8 @@ ImportPackageLanguage::ImportPackageLanguage(){
 	foreach( const IndexedString &each, pFiles ){
 		qDebug() << "KDevDScript ImportPackageLanguage: add file" << each;
 	}
+	
+	pPhaseBarrier->setFiles( pFiles );
 }
 
 ImportPackage::Ref ImportPackageLanguage::self(){
@@ -41,4 +54,82 @@ ImportPackage::Ref ImportPackageLanguage::self(){
 	return package;
 }
 
+ImportPackageLanguage &ImportPackageLanguage::language(){
+	return *self().staticCast<ImportPackageLanguage>();
+}
+
+
+
+void ImportPackageLanguage::loadSnapshot(){
+	pSnapshotValid = false;
+	pSnapshotVersion.clear();
+	
+	const QString path( QStandardPaths::locate( QStandardPaths::GenericDataLocation,
+		"kdevdragonscriptsupport/dslangdoc.version" ) );
+	if( ! path.isEmpty() ){
+		QFile file( path );
+		if( file.open( QIODevice::ReadOnly ) ){
+			pSnapshotVersion = QString::fromLatin1( file.readAll() ).trimmed();
+		}
+	}
+	
+	if( pSnapshotVersion.isEmpty() ){
+		qDebug() << "KDevDScript ImportPackageLanguage: no snapshot version installed";
+		return;
+	}
+	
+	KConfigGroup cgroup( ICore::self()->activeSession()->config()->group( "dragonscriptsupport" ) );
+	const QString storedVersion( cgroup.readEntry( "langDocSnapshot", "" ) );
+	
+	if( storedVersion != pSnapshotVersion ){
+		qDebug() << "KDevDScript ImportPackageLanguage: snapshot version changed from"
+			<< storedVersion << "to" << pSnapshotVersion << ". reparsing language files";
+		cgroup.deleteEntry( "langDocSnapshot" );
+		reparse();
+		return;
+	}
+	
+	// the stored contexts are up to date. let the phase barrier know about their phases
+	// so files depending on the language files do not have to wait for them
+	int completeCount = 0;
+	{
+	DUChainReadLocker lock;
+	DUChain &duchain = *DUChain::self();
+	
+	foreach( const IndexedString &file, pFiles ){
+		TopDUContext * const context = duchain.chainForDocument( file );
+		if( ! context ){
+			continue;
+		}
+		
+		const int phase = DSParseJob::phaseFromFlags( context->features() );
+		pPhaseBarrier->fileFinished( file, phase );
+		if( phase == 3 ){
+			completeCount++;
+		}
+	}
+	}
+	
+	pSnapshotValid = completeCount == pFiles.size();
+	
+	qDebug() << "KDevDScript ImportPackageLanguage: snapshot" << pSnapshotVersion
+		<< ( pSnapshotValid ? "loaded" : "incomplete" ) << "with" << completeCount
+		<< "of" << pFiles.size() << "files";
+}
+
+void ImportPackageLanguage::storeSnapshotIfComplete(){
+	if( pSnapshotValid || pSnapshotVersion.isEmpty() || ! pPhaseBarrier->reached( 3, IndexedString() ) ){
+		return;
+	}
+	
+	pSnapshotValid = true;
+	
+	const QString version( pSnapshotVersion );
+	QMetaObject::invokeMethod( QCoreApplication::instance(), [ version ](){
+		ICore::self()->activeSession()->config()->group( "dragonscriptsupport" )
+			.writeEntry( "langDocSnapshot", version );
+		qDebug() << "KDevDScript ImportPackageLanguage: stored snapshot" << version;
+	}, Qt::QueuedConnection );
+}
+
 }
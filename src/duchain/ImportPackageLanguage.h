@@ -1,6 +1,8 @@
 #ifndef IMPORTPACKAGELANGUAGE_H
 #define IMPORTPACKAGELANGUAGE_H
 
+#include <atomic>
+
 #include "ImportPackage.h"
 
 
@@ -8,8 +10,19 @@ namespace DragonScript {
 
 /**
  * Import package for Language files.
+ * 
+ * The build installs a version stamp next to the language files. If the stamp matches
+ * the one stored in the session the DUChain stored for the language files is used as
+ * is and the files are never reparsed. If the stamp changed the files are reparsed
+ * once and the new stamp is stored after all files reached the last phase.
  */
 class ImportPackageLanguage : public ImportPackage{
+private:
+	QString pSnapshotVersion;
+	std::atomic<bool> pSnapshotValid;
+	
+	
+	
 public:
 	/**
 	 * Create package. Starts importing as soon as required.
@@ -27,6 +40,32 @@ public:
 	 * Get package from global import package list. Adds package if not present yet.
 	 */
 	static ImportPackage::Ref self();
+	
+	/**
+	 * Get language package from global import package list. Adds package if not present yet.
+	 */
+	static ImportPackageLanguage &language();
+	
+	
+	
+	/** Installed snapshot version or empty string if not found. */
+	inline const QString &snapshotVersion() const{ return pSnapshotVersion; }
+	
+	/** Stored DUChain of language files matches installed snapshot version. */
+	inline bool snapshotValid() const{ return pSnapshotValid; }
+	
+	/**
+	 * Load snapshot. Seeds the phase barrier with the phases of the stored contexts if
+	 * the snapshot version matches. Otherwise reparses all files.
+	 * \note Call on main thread.
+	 */
+	void loadSnapshot();
+	
+	/**
+	 * Store snapshot version if all files reached the last phase. Can be called from
+	 * any thread. Storing is done on the main thread.
+	 */
+	void storeSnapshotIfComplete();
 };
 
 }
@@ -1,4 +1,5 @@
-#include <QMutexLocker>
+#include <QReadLocker>
+#include <QWriteLocker>
 #include <QDebug>
 
 #include "ImportPackage.h"
@@ -8,7 +9,7 @@
 namespace DragonScript {
 
 QVector<ImportPackage::Ref> ImportPackages::packages(){
-	QMutexLocker lock( &pMutex );
+	QReadLocker lock( &pLock );
 	QVector<ImportPackage::Ref> list;
 	foreach( const ImportPackage::Ref &each, pPackages ){
 		list << each;
@@ -17,43 +18,99 @@ QVector<ImportPackage::Ref> ImportPackages::packages(){
 }
 
 ImportPackage::Ref ImportPackages::packageNamed( const QString &name ){
-	QMutexLocker lock( &pMutex );
-	QHash<QString, ImportPackage::Ref>::iterator iter( pPackages.find( name ) );
-	if( iter == pPackages.end() ){
-		return {};
-	}
-	return *iter;
+	QReadLocker lock( &pLock );
+	return pPackages.value( name );
 }
 
 ImportPackage::Ref ImportPackages::packageContaining( const IndexedString &file ){
-	QMutexLocker lock( &pMutex );
-	foreach( const ImportPackage::Ref &each, pPackages ){
-		if( each->files().contains( file ) ){
-			return each;
-		}
-	}
-	return nullptr;
+	QReadLocker lock( &pLock );
+	return pFilePackages.value( file );
 }
 
 void ImportPackages::addPackage( const ImportPackage::Ref &package ){
 	qDebug() << "KDevDScript ImportPackages.addPackage:" << package->name();
-	QMutexLocker lock( &pMutex );
+	const QSet<IndexedString> files( package->files() );
+	
+	QWriteLocker lock( &pLock );
+	
+	const ImportPackage::Ref replaced( pPackages.value( package->name() ) );
+	if( replaced ){
+		removeFilesLocked( replaced, replaced->files() );
+	}
+	
 	pPackages[ package->name() ] = package;
+	addFilesLocked( package, files );
+}
+
+void ImportPackages::packageFilesChanged( const QString &name, const QSet<IndexedString> &added,
+const QSet<IndexedString> &removed ){
+	QWriteLocker lock( &pLock );
+	
+	const ImportPackage::Ref package( pPackages.value( name ) );
+	if( ! package ){
+		return;
+	}
+	
+	removeFilesLocked( package, removed );
+	addFilesLocked( package, added );
 }
 
 void ImportPackages::reparseNamed( const QString &name ){
-	QMutexLocker lock( &pMutex );
-	QHash<QString, ImportPackage::Ref>::iterator iter( pPackages.find( name ) );
-	if( iter != pPackages.end() ){
-		(*iter)->reparse();
+	const ImportPackage::Ref package( packageNamed( name ) );
+	if( package ){
+		package->reparse();
 	}
 }
 
 void ImportPackages::reparseAll(){
-	QMutexLocker lock( &pMutex );
-	foreach( const ImportPackage::Ref &package, pPackages ){
+	foreach( const ImportPackage::Ref &package, packages() ){
 		package->reparse();
 	}
 }
 
+
+
+void ImportPackages::addFilesLocked( const ImportPackage::Ref &package, const QSet<IndexedString> &files ){
+	foreach( const IndexedString &file, files ){
+		// files in multiple packages stick to the first package
+		if( ! pFilePackages.contains( file ) ){
+			pFilePackages.insert( file, package );
+		}
+	}
+}
+
+void ImportPackages::removeFilesLocked( const ImportPackage::Ref &package, const QSet<IndexedString> &files ){
+	QSet<IndexedString> orphaned;
+	
+	foreach( const IndexedString &file, files ){
+		const QHash<IndexedString, ImportPackage::Ref>::iterator iter( pFilePackages.find( file ) );
+		if( iter != pFilePackages.end() && *iter == package ){
+			pFilePackages.erase( iter );
+			orphaned << file;
+		}
+	}
+	
+	// files in multiple packages move to a remaining package containing them
+	foreach( const ImportPackage::Ref &each, pPackages ){
+		if( orphaned.isEmpty() ){
+			break;
+		}
+		if( each == package ){
+			continue;
+		}
+		
+		const QSet<IndexedString> packageFiles( each->files() );
+		QSet<IndexedString>::iterator iter( orphaned.begin() );
+		while( iter != orphaned.end() ){
+			if( packageFiles.contains( *iter ) ){
+				pFilePackages.insert( *iter, each );
+				iter = orphaned.erase( iter );
+				
+			}else{
+				iter++;
+			}
+		}
+	}
+}
+
 }
@@ -2,7 +2,8 @@
 #define IMPORTPACKAGES_H
 
 #include <QHash>
-#include <QMutex>
+#include <QSet>
+#include <QReadWriteLock>
 #include <QString>
 #include <QVector>
 
@@ -17,11 +18,16 @@ namespace DragonScript {
 
 /**
  * Stores import packages.
+ * 
+ * Keeps a map from files to the package containing them. Looking up the package of a
+ * file is thus a single hash probe. Files contained in multiple packages map to one of
+ * them and move to another one if they are removed from it.
  */
 class ImportPackages{
 private:
-	QMutex pMutex;
+	QReadWriteLock pLock;
 	QHash<QString, ImportPackage::Ref> pPackages;
+	QHash<IndexedString, ImportPackage::Ref> pFilePackages;
 	
 	
 	
@@ -46,6 +52,12 @@ public:
 	 */
 	void addPackage( const ImportPackage::Ref &package );
 	
+	/**
+	 * Files of named import package changed.
+	 */
+	void packageFilesChanged( const QString &name, const QSet<IndexedString> &added,
+		const QSet<IndexedString> &removed );
+	
 	/**
 	 * Reparse files of named import package if present.
 	 */
@@ -55,6 +67,12 @@ public:
 	 * Reparse all import packages.
 	 */
 	void reparseAll();
+	
+	
+	
+private:
+	void addFilesLocked( const ImportPackage::Ref &package, const QSet<IndexedString> &files );
+	void removeFilesLocked( const ImportPackage::Ref &package, const QSet<IndexedString> &files );
 };
 
 }
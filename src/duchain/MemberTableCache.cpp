@@ -0,0 +1,92 @@
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <language/duchain/topducontext.h>
+
+#include "MemberTableCache.h"
+#include "TypeFinder.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+// global instance
+MemberTableCache MemberTableCache::pSelf;
+
+
+bool MemberTableCache::members( const ClassDeclaration &declaration, TypeFinder &typeFinder,
+DeclarationList &members ){
+	Table table;
+	{
+	QReadLocker lock( &pLock );
+	const QHash<IndexedDeclaration, Table>::const_iterator iter(
+		pTables.constFind( IndexedDeclaration( &declaration ) ) );
+	if( iter == pTables.constEnd() ){
+		return false;
+	}
+	table = *iter;
+	}
+	
+	foreach( uint topContext, table.topContexts ){
+		if( ! typeFinder.isSearchContext( topContext ) ){
+			return false;
+		}
+	}
+	
+	DeclarationList found;
+	found.reserve( table.members.size() );
+	
+	QVector<QPair<IndexedDeclaration, int>>::const_iterator iter;
+	for( iter = table.members.constBegin(); iter != table.members.constEnd(); iter++ ){
+		Declaration * const member = iter->first.declaration();
+		if( ! member ){
+			return false; // top context has been unloaded
+		}
+		found << QPair<Declaration*, int>{ member, iter->second };
+	}
+	
+	members = found;
+	return true;
+}
+
+void MemberTableCache::add( const ClassDeclaration &declaration, const DeclarationList &members,
+const QSet<uint> &topContexts ){
+	const IndexedDeclaration indexed( &declaration );
+	
+	Table table;
+	table.topContexts = topContexts;
+	table.members.reserve( members.size() );
+	foreach( const auto &each, members ){
+		table.members << QPair<IndexedDeclaration, int>{ IndexedDeclaration( each.first ), each.second };
+	}
+	
+	QWriteLocker lock( &pLock );
+	pTables.insert( indexed, table );
+	foreach( uint topContext, topContexts ){
+		pContextTables[ topContext ].insert( indexed );
+	}
+}
+
+void MemberTableCache::removeTopContext( uint topContextIndex ){
+	QWriteLocker lock( &pLock );
+	
+	const QSet<IndexedDeclaration> tables( pContextTables.take( topContextIndex ) );
+	foreach( const IndexedDeclaration &each, tables ){
+		const Table table( pTables.take( each ) );
+		
+		// drop references of the other hierarchy top contexts to the removed table
+		foreach( uint topContext, table.topContexts ){
+			const QHash<uint, QSet<IndexedDeclaration>>::iterator iter( pContextTables.find( topContext ) );
+			if( iter == pContextTables.end() ){
+				continue;
+			}
+			iter->remove( each );
+			if( iter->isEmpty() ){
+				pContextTables.erase( iter );
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef MEMBERTABLECACHE_H
+#define MEMBERTABLECACHE_H
+
+#include <language/duchain/classdeclaration.h>
+#include <language/duchain/indexeddeclaration.h>
+
+#include <QHash>
+#include <QSet>
+#include <QPair>
+#include <QVector>
+#include <QReadWriteLock>
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+class TypeFinder;
+
+/**
+ * Global cache of flattened base class member tables.
+ * 
+ * Stores per class declaration the consolidated members of all base classes and
+ * interfaces together with their override depth. Each table records the top contexts
+ * the classes of the hierarchy are located in. Before a top context is rebuilt all
+ * tables depending on it are dropped.
+ * 
+ * Tables are only used if all top contexts of the hierarchy are search contexts of the
+ * type finder asking. Otherwise the hierarchy could resolve differently for the job.
+ * 
+ * This class works as singleton and is thread safe.
+ */
+class MemberTableCache{
+public:
+	/** Declaration with override depth. */
+	typedef QVector<QPair<Declaration*, int>> DeclarationList;
+	
+	/** Global instance. */
+	static inline MemberTableCache &self(){ return pSelf; }
+	
+	
+	
+	/**
+	 * Get cached base member table of class declaration. Returns false if not cached.
+	 * \note DUChainReadLocker required.
+	 */
+	bool members( const ClassDeclaration &declaration, TypeFinder &typeFinder, DeclarationList &members );
+	
+	/**
+	 * Add base member table of class declaration.
+	 * \note DUChainReadLocker required.
+	 */
+	void add( const ClassDeclaration &declaration, const DeclarationList &members,
+		const QSet<uint> &topContexts );
+	
+	/** Remove all tables with a class of the hierarchy located in top context. */
+	void removeTopContext( uint topContextIndex );
+	
+	
+	
+private:
+	struct Table{
+		QVector<QPair<IndexedDeclaration, int>> members;
+		QSet<uint> topContexts;
+	};
+	
+	MemberTableCache() = default;
+	
+	static MemberTableCache pSelf;
+	
+	QReadWriteLock pLock;
+	QHash<IndexedDeclaration, Table> pTables;
+	QHash<uint, QSet<IndexedDeclaration>> pContextTables;
+};
+
+}
+
+#endif
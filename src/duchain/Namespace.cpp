@@ -5,6 +5,7 @@
 
 #include "Namespace.h"
 #include "TypeFinder.h"
+#include "NamespaceIndex.h"
 #include "Helpers.h"
 
 
@@ -13,15 +14,18 @@ using namespace KDevelop;
 namespace DragonScript {
 
 Namespace::Namespace( TypeFinder &typeFinder ) :
+pTypeFinder( typeFinder ),
 pParent( nullptr ),
 pDirtyContent( true )
 {
+	NamespaceIndex &index = NamespaceIndex::self();
 	foreach( const ReferencedTopDUContext &each, typeFinder.searchContexts() ){
-		pContexts << DUContextPointer( each.data() );
+		index.ensureTopContext( each.data() );
 	}
 }
 
 Namespace::Namespace( Namespace &parent, const IndexedIdentifier &identifier ) :
+pTypeFinder( parent.pTypeFinder ),
 pParent( &parent ),
 pIdentifier( identifier ),
 pQualifiedIdentifier( parent.pQualifiedIdentifier.identifier() + identifier ),
@@ -111,6 +115,7 @@ ClassDeclaration *Namespace::getClass( const IndexedIdentifier &iid ){
 		return nullptr;
 		
 	}else{
+		pTypeFinder.noteResolved( iter.value().data() );
 		return iter.value().data();
 	}
 }
@@ -119,52 +124,52 @@ ClassDeclaration *Namespace::getClass( const IndexedIdentifier &iid ){
 
 void Namespace::findContent(){
 	pDirtyContent = false;
-	foreach( const DUContextPointer &context, pContexts ){
-		if( ! context ){
+	
+	const QVector<NamespaceIndex::Entry> entries( NamespaceIndex::self().entries( pQualifiedIdentifier ) );
+	foreach( const NamespaceIndex::Entry &entry, entries ){
+		if( ! pTypeFinder.isSearchContext( entry.topContext ) ){
 			continue;
 		}
-		const QVector<Declaration*> declarations( context->localDeclarations() );
-		foreach( Declaration *decl, declarations ){
-			if( decl->kind() == Declaration::Type ){
-				ClassDeclaration * const classDecl = dynamic_cast<ClassDeclaration*>( decl );
-				if( ! classDecl ){
-					continue;
-				}
-				
-				const IndexedIdentifier &identifier = classDecl->indexedIdentifier();
-				if( pClasses.contains( identifier ) ){
-					// duplicate class is a bug. stick to the first found one
-					continue;
-				}
-				
-				pClasses.insert( identifier, ClassDeclarationPointer( classDecl ) );
-				
-			}else if( decl->kind() == Declaration::Namespace ){
-				const IndexedIdentifier &identifier = decl->indexedIdentifier();
-				if( pClasses.contains( identifier ) ){
-					// namespace with same name as a class is a bug. stick to the class
-					continue;
-				}
-				
-				const TypeNamespaceMap::const_iterator iter( pNamespaces.constFind( identifier ) );
-				Namespace *ns;
-				
-				if( iter != pNamespaces.cend() ){
-					ns = iter.value().data();
-					
-				}else{
-					ns = new Namespace( *this, identifier );
-					pNamespaces.insert( identifier, Ref( ns ) );
-				}
-				
-				DUContext * const ictx = decl->internalContext();
-				if( ictx ){
-					ns->pContexts << DUContextPointer( ictx );
-				}
+		
+		Declaration * const decl = entry.declaration.declaration();
+		if( ! decl || decl->indexedIdentifier() != entry.identifier ){
+			continue; // top context has been rebuilt in the mean time
+		}
+		
+		if( ! entry.isNamespace ){
+			ClassDeclaration * const classDecl = dynamic_cast<ClassDeclaration*>( decl );
+			if( ! classDecl ){
+				continue;
+			}
+			
+			const IndexedIdentifier &identifier = classDecl->indexedIdentifier();
+			if( pClasses.contains( identifier ) ){
+				// duplicate class is a bug. stick to the first found one
+				continue;
+			}
+			
+			pClasses.insert( identifier, ClassDeclarationPointer( classDecl ) );
+			
+		}else{
+			const IndexedIdentifier &identifier = decl->indexedIdentifier();
+			if( pClasses.contains( identifier ) ){
+				// namespace with same name as a class is a bug. stick to the class
+				continue;
+			}
+			
+			const TypeNamespaceMap::const_iterator iter( pNamespaces.constFind( identifier ) );
+			Namespace *ns;
+			
+			if( iter != pNamespaces.cend() ){
+				ns = iter.value().data();
 				
-				if( ! ns->pDeclaration ){
-					ns->pDeclaration = dynamic_cast<ClassDeclaration*>( decl );
-				}
+			}else{
+				ns = new Namespace( *this, identifier );
+				pNamespaces.insert( identifier, Ref( ns ) );
+			}
+			
+			if( ! ns->pDeclaration ){
+				ns->pDeclaration = dynamic_cast<ClassDeclaration*>( decl );
 			}
 		}
 	}
@@ -20,11 +20,11 @@ class TypeFinder;
  * Namespace.
  * 
  * Stores encountered namespaces and their contained classes in a lazy way. Upon encountering
- * an unknown namespace the namespace is looked up in the type finder search contexts.
- * If found the namespace is stored. If namespaces or classes inside a found namespace are
- * searched the namespaces respective classes are looked up when needed. This way only the
- * encountered part of the namespace space is looked up while storing the result for upcoming
- * queries.
+ * an unknown namespace the namespace is looked up in the global NamespaceIndex filtered
+ * by the type finder search contexts. If found the namespace is stored. If namespaces or
+ * classes inside a found namespace are searched the namespaces respective classes are
+ * looked up when needed. This way only the encountered part of the namespace space is
+ * looked up while storing the result for upcoming queries.
  * 
  * \note Locking DUChainReadLocker is required.
  * 
@@ -55,17 +55,16 @@ public:
 	typedef QSharedPointer<Namespace> Ref;
 	typedef QHash<IndexedIdentifier, Ref> TypeNamespaceMap;
 	typedef QHash<IndexedIdentifier, ClassDeclarationPointer> TypeClassMap;
-	typedef QSet<DUContextPointer> TypeContextList;
 	
 	
 	
 private:
+	TypeFinder &pTypeFinder;
 	Namespace *pParent;
 	IndexedIdentifier pIdentifier;
 	IndexedQualifiedIdentifier pQualifiedIdentifier;
 	TypeNamespaceMap pNamespaces;
 	TypeClassMap pClasses;
-	TypeContextList pContexts;
 	bool pDirtyContent;
 	ClassDeclarationPointer pDeclaration;
 	
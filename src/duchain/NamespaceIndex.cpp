@@ -0,0 +1,120 @@
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <language/duchain/classdeclaration.h>
+
+#include "NamespaceIndex.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+// global instance
+NamespaceIndex NamespaceIndex::pSelf;
+
+
+void NamespaceIndex::ensureTopContext( TopDUContext *context ){
+	if( ! context ){
+		return;
+	}
+	
+	const uint topContextIndex = context->ownIndex();
+	{
+	QReadLocker lock( &pLock );
+	if( pContextNamespaces.contains( topContextIndex ) ){
+		return;
+	}
+	}
+	
+	EntryMap entries;
+	collect( *context, IndexedQualifiedIdentifier(), topContextIndex, entries );
+	
+	QWriteLocker lock( &pLock );
+	if( ! pContextNamespaces.contains( topContextIndex ) ){
+		replace( topContextIndex, entries );
+	}
+}
+
+void NamespaceIndex::updateTopContext( TopDUContext *context ){
+	if( ! context ){
+		return;
+	}
+	
+	const uint topContextIndex = context->ownIndex();
+	EntryMap entries;
+	collect( *context, IndexedQualifiedIdentifier(), topContextIndex, entries );
+	
+	QWriteLocker lock( &pLock );
+	removeLocked( topContextIndex );
+	replace( topContextIndex, entries );
+}
+
+void NamespaceIndex::removeTopContext( uint topContextIndex ){
+	QWriteLocker lock( &pLock );
+	removeLocked( topContextIndex );
+}
+
+QVector<NamespaceIndex::Entry> NamespaceIndex::entries( const IndexedQualifiedIdentifier &ns ){
+	QReadLocker lock( &pLock );
+	return pEntries.value( ns );
+}
+
+
+
+void NamespaceIndex::collect( DUContext &context, const IndexedQualifiedIdentifier &ns,
+uint topContext, EntryMap &entries ){
+	const QVector<Declaration*> declarations( context.localDeclarations() );
+	foreach( Declaration *decl, declarations ){
+		if( decl->kind() == Declaration::Type ){
+			if( dynamic_cast<ClassDeclaration*>( decl ) ){
+				entries[ ns ] << Entry{ topContext, IndexedDeclaration( decl ), decl->indexedIdentifier(), false };
+			}
+			
+		}else if( decl->kind() == Declaration::Namespace ){
+			entries[ ns ] << Entry{ topContext, IndexedDeclaration( decl ), decl->indexedIdentifier(), true };
+			
+			DUContext * const ictx = decl->internalContext();
+			if( ictx ){
+				collect( *ictx, IndexedQualifiedIdentifier( ns.identifier() + decl->identifier() ),
+					topContext, entries );
+			}
+		}
+	}
+}
+
+void NamespaceIndex::replace( uint topContextIndex, const EntryMap &entries ){
+	QSet<IndexedQualifiedIdentifier> &namespaces = pContextNamespaces[ topContextIndex ];
+	
+	EntryMap::const_iterator iter;
+	for( iter = entries.cbegin(); iter != entries.cend(); iter++ ){
+		pEntries[ iter.key() ] << iter.value();
+		namespaces.insert( iter.key() );
+	}
+}
+
+void NamespaceIndex::removeLocked( uint topContextIndex ){
+	const QSet<IndexedQualifiedIdentifier> namespaces( pContextNamespaces.take( topContextIndex ) );
+	foreach( const IndexedQualifiedIdentifier &ns, namespaces ){
+		const EntryMap::iterator iter( pEntries.find( ns ) );
+		if( iter == pEntries.end() ){
+			continue;
+		}
+		
+		QVector<Entry>::iterator iterEntry( iter->begin() );
+		while( iterEntry != iter->end() ){
+			if( iterEntry->topContext == topContextIndex ){
+				iterEntry = iter->erase( iterEntry );
+				
+			}else{
+				iterEntry++;
+			}
+		}
+		
+		if( iter->isEmpty() ){
+			pEntries.erase( iter );
+		}
+	}
+}
+
+}
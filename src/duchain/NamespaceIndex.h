@@ -0,0 +1,90 @@
+#ifndef NAMESPACEINDEX_H
+#define NAMESPACEINDEX_H
+
+#include <language/duchain/declaration.h>
+#include <language/duchain/indexeddeclaration.h>
+#include <language/duchain/identifier.h>
+#include <language/duchain/topducontext.h>
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QReadWriteLock>
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+/**
+ * Global index of namespace content.
+ * 
+ * Stores for each namespace the classes and child namespaces declared in it. Each top
+ * context contributes its declarations once. Contributions are replaced after the top
+ * context has been rebuilt. Namespace uses this index to find content instead of
+ * scanning the local declarations of all search contexts for every parse job and code
+ * completion request.
+ * 
+ * Top contexts loaded from the DUChain store are added the first time they are used
+ * as search context.
+ * 
+ * This class works as singleton and is thread safe.
+ */
+class NamespaceIndex{
+public:
+	/** Index entry. */
+	struct Entry{
+		uint topContext;
+		IndexedDeclaration declaration;
+		IndexedIdentifier identifier;
+		bool isNamespace;
+	};
+	
+	
+	
+	/** Global instance. */
+	static inline NamespaceIndex &self(){ return pSelf; }
+	
+	
+	
+	/**
+	 * Add top context if not added yet.
+	 * \note DUChainReadLocker required.
+	 */
+	void ensureTopContext( TopDUContext *context );
+	
+	/**
+	 * Replace contributions of top context after it has been rebuilt.
+	 * \note DUChainReadLocker required.
+	 */
+	void updateTopContext( TopDUContext *context );
+	
+	/** Remove contributions of top context. */
+	void removeTopContext( uint topContextIndex );
+	
+	/** Entries declared in namespace. */
+	QVector<Entry> entries( const IndexedQualifiedIdentifier &ns );
+	
+	
+	
+private:
+	typedef QHash<IndexedQualifiedIdentifier, QVector<Entry>> EntryMap;
+	
+	NamespaceIndex() = default;
+	
+	static void collect( DUContext &context, const IndexedQualifiedIdentifier &ns,
+		uint topContext, EntryMap &entries );
+	
+	void replace( uint topContextIndex, const EntryMap &entries );
+	void removeLocked( uint topContextIndex );
+	
+	static NamespaceIndex pSelf;
+	
+	QReadWriteLock pLock;
+	EntryMap pEntries;
+	QHash<uint, QSet<IndexedQualifiedIdentifier>> pContextNamespaces;
+};
+
+}
+
+#endif
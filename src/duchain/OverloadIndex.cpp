@@ -0,0 +1,51 @@
+#include <language/duchain/types/functiontype.h>
+
+#include "OverloadIndex.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+OverloadIndex::OverloadSet OverloadIndex::overloads( const DUContext &context,
+const IndexedIdentifier &identifier, const Lookup &lookup ){
+	const QPair<const DUContext*, IndexedIdentifier> key( &context, identifier );
+	const QHash<QPair<const DUContext*, IndexedIdentifier>, OverloadSet>::const_iterator
+		iter( pSets.constFind( key ) );
+	if( iter != pSets.constEnd() ){
+		return *iter;
+	}
+	
+	const QVector<Declaration*> declarations( lookup() );
+	
+	OverloadSet set;
+	set.declarationCount = declarations.size();
+	set.firstIsFunction = ! declarations.isEmpty()
+		&& dynamic_cast<ClassFunctionDeclaration*>( declarations.first() );
+	
+	foreach( Declaration *declaration, declarations ){
+		ClassFunctionDeclaration * const funcDecl = dynamic_cast<ClassFunctionDeclaration*>( declaration );
+		if( ! funcDecl ){
+			continue;
+		}
+		
+		const FunctionType::Ptr funcType = funcDecl->type<FunctionType>();
+		if( ! funcType ){
+			continue;
+		}
+		
+		Candidate candidate;
+		candidate.declaration = funcDecl;
+		candidate.arguments = funcType->arguments().toVector();
+		set.functions[ candidate.arguments.size() ] << candidate;
+	}
+	
+	pSets.insert( key, set );
+	return set;
+}
+
+void OverloadIndex::clear(){
+	pSets.clear();
+}
+
+}
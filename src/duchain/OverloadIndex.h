@@ -0,0 +1,86 @@
+#ifndef OVERLOADINDEX_H
+#define OVERLOADINDEX_H
+
+#include <language/duchain/classfunctiondeclaration.h>
+#include <language/duchain/ducontext.h>
+#include <language/duchain/identifier.h>
+#include <language/duchain/types/abstracttype.h>
+
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
+#include <functional>
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+/**
+ * Overload sets of called functions.
+ * 
+ * Resolving a function call looks up all declarations matching the called name in the
+ * context and its base classes. These are then filtered for functions with matching
+ * argument count. The index stores the result per context and identifier with the
+ * functions grouped by argument count and their argument types extracted. Resolving the
+ * same call again touches only the functions with matching argument count.
+ * 
+ * The index is only valid while the declarations it has been built from do not change.
+ * UseBuilder keeps one for the duration of building uses.
+ * 
+ * \note DUChainReadLocker required.
+ */
+class OverloadIndex{
+public:
+	/** Function with extracted argument types. */
+	struct Candidate{
+		ClassFunctionDeclaration *declaration;
+		QVector<AbstractType::Ptr> arguments;
+	};
+	
+	typedef QVector<Candidate> CandidateList;
+	
+	/** Overload set of context and identifier. */
+	struct OverloadSet{
+		/** Number of found declarations including non-functions. */
+		int declarationCount = 0;
+		
+		/** First found declaration is a function. */
+		bool firstIsFunction = false;
+		
+		/** Functions by argument count in the order they have been found. */
+		QHash<int, CandidateList> functions;
+		
+		/** Functions with argument count. */
+		inline CandidateList candidates( int argumentCount ) const{
+			return functions.value( argumentCount );
+		}
+	};
+	
+	/** Find declarations matching name. */
+	typedef std::function<QVector<Declaration*>()> Lookup;
+	
+	
+	
+	OverloadIndex() = default;
+	
+	/**
+	 * Overload set for context and identifier. If absent \em lookup is called to find the
+	 * declarations to build the overload set from.
+	 */
+	OverloadSet overloads( const DUContext &context, const IndexedIdentifier &identifier,
+		const Lookup &lookup );
+	
+	/** Clear index. */
+	void clear();
+	
+	
+	
+private:
+	QHash<QPair<const DUContext*, IndexedIdentifier>, OverloadSet> pSets;
+};
+
+}
+
+#endif
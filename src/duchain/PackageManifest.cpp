@@ -0,0 +1,384 @@
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+#include <QDebug>
+
+#include "PackageManifest.h"
+
+
+namespace DragonScript {
+
+static const quint32 manifestVersion = 1;
+
+static qint64 modificationTime( const QFileInfo &info ){
+	return info.lastModified().toMSecsSinceEpoch();
+}
+
+
+PackageManifest::Ref PackageManifest::create( const QString &name, const QStringList &directories ){
+	const Ref manifest( new PackageManifest( name, directories ), &QObject::deleteLater );
+	manifest->load();
+	
+	// packages are usually created by parse jobs. the watcher has to live on the main
+	// thread to receive notifications
+	manifest->moveToThread( QCoreApplication::instance()->thread() );
+	
+	const QWeakPointer<PackageManifest> weak( manifest );
+	QMetaObject::invokeMethod( QCoreApplication::instance(), [ weak ](){
+		const Ref strong( weak.toStrongRef() );
+		if( strong ){
+			strong->startWatching();
+		}
+	}, Qt::QueuedConnection );
+	
+	return manifest;
+}
+
+PackageManifest::PackageManifest( const QString &name, const QStringList &directories ) :
+pName( name ),
+pDirectories( directories ),
+pWatcher( nullptr ){
+}
+
+PackageManifest::~PackageManifest(){
+}
+
+
+
+QSet<IndexedString> PackageManifest::files(){
+	QMutexLocker lock( &pMutex );
+	QSet<IndexedString> files;
+	
+	QHash<QString, Directory>::const_iterator iter;
+	for( iter = pDirectoryMap.cbegin(); iter != pDirectoryMap.cend(); iter++ ){
+		const QString prefix( iter.key() + "/" );
+		QHash<QString, FileInfo>::const_iterator iterFile;
+		for( iterFile = iter->files.cbegin(); iterFile != iter->files.cend(); iterFile++ ){
+			files << IndexedString( prefix + iterFile.key() );
+		}
+	}
+	
+	return files;
+}
+
+QSet<IndexedString> PackageManifest::modifiedFiles(){
+	QMutexLocker lock( &pMutex );
+	
+	Changes changes;
+	foreach( const QString &directory, pDirectories ){
+		validateDirectory( directory, changes );
+	}
+	
+	QSet<IndexedString> files;
+	
+	QHash<QString, Directory>::iterator iter;
+	for( iter = pDirectoryMap.begin(); iter != pDirectoryMap.end(); iter++ ){
+		const QString prefix( iter.key() + "/" );
+		QHash<QString, FileInfo>::iterator iterFile;
+		for( iterFile = iter->files.begin(); iterFile != iter->files.end(); iterFile++ ){
+			const QFileInfo info( prefix + iterFile.key() );
+			const qint64 modified = modificationTime( info );
+			if( modified != iterFile->modified || info.size() != iterFile->size ){
+				iterFile->modified = modified;
+				iterFile->size = info.size();
+				files << IndexedString( info.filePath() );
+			}
+		}
+	}
+	
+	writeCache();
+	lock.unlock();
+	
+	// added and removed files are reported the same way as watched directory changes
+	if( QThread::currentThread() == thread() ){
+		applyChanges( changes );
+		
+	}else{
+		QMetaObject::invokeMethod( this, [ this, changes ](){
+			applyChanges( changes );
+		}, Qt::QueuedConnection );
+	}
+	
+	return files;
+}
+
+void PackageManifest::setChangedCallback( const ChangedCallback &callback ){
+	QMutexLocker lock( &pCallbackMutex );
+	pChangedCallback = callback;
+}
+
+
+
+void PackageManifest::onDirectoryChanged( const QString &path ){
+	Changes changes;
+	{
+	QMutexLocker lock( &pMutex );
+	if( ! pDirectoryMap.contains( path ) ){
+		return;
+	}
+	
+	scanDirectory( path, changes, false );
+	writeCache();
+	}
+	
+	if( ! changes.addedFiles.isEmpty() || ! changes.removedFiles.isEmpty() ){
+		qDebug() << "KDevDScript PackageManifest" << pName << ": directory changed" << path
+			<< ":" << changes.addedFiles.size() << "added," << changes.removedFiles.size() << "removed";
+	}
+	
+	applyChanges( changes );
+}
+
+void PackageManifest::applyChanges( const Changes &changes ){
+	// watcher is missing if the changes are found before watching started. it adds all
+	// known directories once started
+	if( pWatcher ){
+		if( ! changes.removedDirectories.isEmpty() ){
+			pWatcher->removePaths( changes.removedDirectories );
+		}
+		if( ! changes.addedDirectories.isEmpty() ){
+			pWatcher->addPaths( changes.addedDirectories );
+		}
+	}
+	
+	if( changes.addedFiles.isEmpty() && changes.removedFiles.isEmpty() ){
+		return;
+	}
+	
+	QMutexLocker lock( &pCallbackMutex );
+	if( pChangedCallback ){
+		pChangedCallback( changes.addedFiles, changes.removedFiles );
+	}
+}
+
+
+
+void PackageManifest::load(){
+	QMutexLocker lock( &pMutex );
+	
+	const bool cached = readCache();
+	
+	Changes changes;
+	foreach( const QString &directory, pDirectories ){
+		validateDirectory( directory, changes );
+	}
+	
+	int fileCount = 0;
+	foreach( const Directory &directory, pDirectoryMap ){
+		fileCount += directory.files.size();
+	}
+	
+	qDebug() << "KDevDScript PackageManifest" << pName << ":" << pDirectoryMap.size()
+		<< "directories with" << fileCount << "files." << changes.scannedDirectories
+		<< "directories scanned" << ( cached ? "(cached)" : "(not cached)" );
+	
+	if( ! cached || changes.scannedDirectories > 0 || ! changes.removedDirectories.isEmpty() ){
+		writeCache();
+	}
+}
+
+bool PackageManifest::readCache(){
+	QFile file( cachePath() );
+	if( ! file.open( QIODevice::ReadOnly ) ){
+		return false;
+	}
+	
+	QDataStream stream( &file );
+	quint32 version;
+	QStringList directories;
+	stream >> version;
+	if( version != manifestVersion ){
+		return false;
+	}
+	
+	stream >> directories;
+	if( directories != pDirectories ){
+		return false;
+	}
+	
+	quint32 directoryCount;
+	stream >> directoryCount;
+	
+	QHash<QString, Directory> directoryMap;
+	directoryMap.reserve( directoryCount );
+	
+	quint32 i, j;
+	for( i=0; i<directoryCount; i++ ){
+		QString path;
+		Directory directory;
+		quint32 fileCount;
+		stream >> path >> directory.modified >> directory.subdirectories >> fileCount;
+		
+		directory.files.reserve( fileCount );
+		for( j=0; j<fileCount; j++ ){
+			QString name;
+			FileInfo info;
+			stream >> name >> info.modified >> info.size;
+			directory.files.insert( name, info );
+		}
+		
+		directoryMap.insert( path, directory );
+	}
+	
+	if( stream.status() != QDataStream::Ok ){
+		return false;
+	}
+	
+	pDirectoryMap.swap( directoryMap );
+	return true;
+}
+
+void PackageManifest::writeCache(){
+	const QString path( cachePath() );
+	QDir().mkpath( QFileInfo( path ).absolutePath() );
+	
+	QFile file( path );
+	if( ! file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ){
+		qDebug() << "KDevDScript PackageManifest" << pName << ": failed writing" << path;
+		return;
+	}
+	
+	QDataStream stream( &file );
+	stream << manifestVersion << pDirectories << ( quint32 )pDirectoryMap.size();
+	
+	QHash<QString, Directory>::const_iterator iter;
+	for( iter = pDirectoryMap.cbegin(); iter != pDirectoryMap.cend(); iter++ ){
+		stream << iter.key() << iter->modified << iter->subdirectories << ( quint32 )iter->files.size();
+		
+		QHash<QString, FileInfo>::const_iterator iterFile;
+		for( iterFile = iter->files.cbegin(); iterFile != iter->files.cend(); iterFile++ ){
+			stream << iterFile.key() << iterFile->modified << iterFile->size;
+		}
+	}
+}
+
+QString PackageManifest::cachePath() const{
+	const QByteArray key( ( pName + "\n" + pDirectories.join( "\n" ) ).toUtf8() );
+	return QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation )
+		+ "/kdevdragonscriptsupport/manifests/"
+		+ QString::fromLatin1( QCryptographicHash::hash( key, QCryptographicHash::Sha1 ).toHex() );
+}
+
+void PackageManifest::startWatching(){
+	if( pWatcher ){
+		return;
+	}
+	
+	pWatcher = new QFileSystemWatcher( this );
+	connect( pWatcher, &QFileSystemWatcher::directoryChanged, this, &PackageManifest::onDirectoryChanged );
+	
+	QStringList paths;
+	{
+	QMutexLocker lock( &pMutex );
+	paths = pDirectoryMap.keys();
+	}
+	
+	if( ! paths.isEmpty() ){
+		pWatcher->addPaths( paths );
+	}
+}
+
+
+
+void PackageManifest::validateDirectory( const QString &path, Changes &changes ){
+	const QFileInfo info( path );
+	const QHash<QString, Directory>::const_iterator iter( pDirectoryMap.constFind( path ) );
+	
+	if( iter == pDirectoryMap.cend() || ! info.isDir() || iter->modified != modificationTime( info ) ){
+		scanDirectory( path, changes, true );
+		return;
+	}
+	
+	const QStringList subdirectories( iter->subdirectories );
+	foreach( const QString &subdirectory, subdirectories ){
+		validateDirectory( subdirectory, changes );
+	}
+}
+
+void PackageManifest::scanDirectory( const QString &path, Changes &changes, bool validateSubdirectories ){
+	const QFileInfo info( path );
+	if( ! info.isDir() ){
+		removeDirectory( path, changes );
+		return;
+	}
+	
+	const bool known = pDirectoryMap.contains( path );
+	const Directory old( pDirectoryMap.value( path ) );
+	if( ! known ){
+		changes.addedDirectories << path;
+	}
+	
+	Directory directory;
+	directory.modified = modificationTime( info );
+	changes.scannedDirectories++;
+	
+	const QDir dir( path );
+	const QString prefix( path + "/" );
+	
+	foreach( const QFileInfo &each, dir.entryInfoList( QStringList() << "*.ds", QDir::Files ) ){
+		const QString name( each.fileName() );
+		directory.files.insert( name, FileInfo{ modificationTime( each ), each.size() } );
+		if( ! old.files.contains( name ) ){
+			changes.addedFiles << IndexedString( prefix + name );
+		}
+	}
+	
+	QHash<QString, FileInfo>::const_iterator iterOld;
+	for( iterOld = old.files.cbegin(); iterOld != old.files.cend(); iterOld++ ){
+		if( ! directory.files.contains( iterOld.key() ) ){
+			changes.removedFiles << IndexedString( prefix + iterOld.key() );
+		}
+	}
+	
+	foreach( const QFileInfo &each, dir.entryInfoList( QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks ) ){
+		directory.subdirectories << each.filePath();
+	}
+	
+	pDirectoryMap.insert( path, directory );
+	
+	foreach( const QString &subdirectory, old.subdirectories ){
+		if( ! directory.subdirectories.contains( subdirectory ) ){
+			removeDirectory( subdirectory, changes );
+		}
+	}
+	
+	foreach( const QString &subdirectory, directory.subdirectories ){
+		if( ! pDirectoryMap.contains( subdirectory ) ){
+			scanDirectory( subdirectory, changes, false );
+			
+		}else if( validateSubdirectories ){
+			validateDirectory( subdirectory, changes );
+		}
+	}
+}
+
+void PackageManifest::removeDirectory( const QString &path, Changes &changes ){
+	const QHash<QString, Directory>::iterator iter( pDirectoryMap.find( path ) );
+	if( iter == pDirectoryMap.end() ){
+		return;
+	}
+	
+	const Directory directory( *iter );
+	pDirectoryMap.erase( iter );
+	changes.removedDirectories << path;
+	
+	const QString prefix( path + "/" );
+	QHash<QString, FileInfo>::const_iterator iterFile;
+	for( iterFile = directory.files.cbegin(); iterFile != directory.files.cend(); iterFile++ ){
+		changes.removedFiles << IndexedString( prefix + iterFile.key() );
+	}
+	
+	foreach( const QString &subdirectory, directory.subdirectories ){
+		removeDirectory( subdirectory, changes );
+	}
+}
+
+}
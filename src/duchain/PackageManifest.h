@@ -0,0 +1,131 @@
+#ifndef PACKAGEMANIFEST_H
+#define PACKAGEMANIFEST_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <serialization/indexedstring.h>
+
+#include <functional>
+
+
+class QFileSystemWatcher;
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+/**
+ * Manifest of script files in package directories.
+ * 
+ * Stores for each directory the modification time, the contained script files with their
+ * modification time and size as well as the sub directories. The manifest is persisted
+ * in the cache directory. On creation the stored manifest is validated by checking the
+ * modification time of the directories only. Only directories with changed modification
+ * time are listed again. This avoids walking large directory trees every session.
+ * 
+ * After creation the directories are watched for changes. Adding and removing files
+ * updates the manifest and notifies the changed callback.
+ * 
+ * This class is thread safe. The watcher lives on the main thread.
+ */
+class PackageManifest : public QObject{
+	Q_OBJECT
+	
+public:
+	/** Reference type. */
+	typedef QSharedPointer<PackageManifest> Ref;
+	
+	/** Callback for added and removed files. Called on main thread. */
+	typedef std::function<void( const QSet<IndexedString> &added,
+		const QSet<IndexedString> &removed )> ChangedCallback;
+	
+	
+	
+	/**
+	 * Create manifest for directories. Loads or scans the manifest and starts watching
+	 * the directories on the main thread.
+	 */
+	static Ref create( const QString &name, const QStringList &directories );
+	
+	/** Clean up manifest. */
+	~PackageManifest() override;
+	
+	
+	
+	/** Script files. */
+	QSet<IndexedString> files();
+	
+	/**
+	 * Files modified since the manifest has been updated the last time. Updates the
+	 * manifest. Added and removed files are reported to the changed callback on the
+	 * main thread and the watched directories are updated.
+	 */
+	QSet<IndexedString> modifiedFiles();
+	
+	/** Set changed callback. */
+	void setChangedCallback( const ChangedCallback &callback );
+	
+	
+	
+private slots:
+	void onDirectoryChanged( const QString &path );
+	
+	
+	
+private:
+	struct FileInfo{
+		qint64 modified;
+		qint64 size;
+	};
+	
+	struct Directory{
+		qint64 modified;
+		QHash<QString, FileInfo> files;
+		QStringList subdirectories;
+	};
+	
+	struct Changes{
+		QSet<IndexedString> addedFiles;
+		QSet<IndexedString> removedFiles;
+		QStringList addedDirectories;
+		QStringList removedDirectories;
+		int scannedDirectories = 0;
+	};
+	
+	PackageManifest( const QString &name, const QStringList &directories );
+	
+	void load();
+	bool readCache();
+	void writeCache();
+	QString cachePath() const;
+	
+	void startWatching();
+	void applyChanges( const Changes &changes );
+	
+	void validateDirectory( const QString &path, Changes &changes );
+	void scanDirectory( const QString &path, Changes &changes, bool validateSubdirectories );
+	void removeDirectory( const QString &path, Changes &changes );
+	
+	
+	
+	const QString pName;
+	const QStringList pDirectories;
+	
+	QMutex pMutex;
+	QHash<QString, Directory> pDirectoryMap;
+	
+	QFileSystemWatcher *pWatcher;
+	
+	QMutex pCallbackMutex;
+	ChangedCallback pChangedCallback;
+};
+
+}
+
+#endif
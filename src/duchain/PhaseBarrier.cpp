@@ -0,0 +1,276 @@
+#include <QMutexLocker>
+
+#include "PhaseBarrier.h"
+
+
+namespace DragonScript {
+
+PhaseBarrier::PhaseBarrier() :
+pGeneration( 1 )
+{
+	for( int i=0; i<4; i++ ){
+		pPhaseCount[ i ] = 0;
+	}
+}
+
+
+
+QSet<IndexedString> PhaseBarrier::files(){
+	QMutexLocker lock( &pMutex );
+	return pFilePhases.keys().toSet();
+}
+
+void PhaseBarrier::setFiles( const QSet<IndexedString> &files ){
+	QMutexLocker lock( &pMutex );
+	
+	WaiterMap ready;
+	const QList<IndexedString> known( pFilePhases.keys() );
+	foreach( const IndexedString &file, known ){
+		if( ! files.contains( file ) ){
+			setPhaseInternal( file, 0 );
+			pFilePhases.remove( file );
+			pRequestedPhases.remove( file );
+			collectReadyFileWaiters( file, 3, ready );
+		}
+	}
+	
+	foreach( const IndexedString &file, files ){
+		if( ! pFilePhases.contains( file ) ){
+			pFilePhases.insert( file, 0 );
+		}
+	}
+	pGeneration++;
+	
+	// removing files can complete the barrier
+	collectReadyWaiters( ready );
+	lock.unlock();
+	schedule( ready );
+}
+
+void PhaseBarrier::addFile( const IndexedString &file ){
+	QMutexLocker lock( &pMutex );
+	if( ! pFilePhases.contains( file ) ){
+		pFilePhases.insert( file, 0 );
+		pGeneration++;
+	}
+}
+
+void PhaseBarrier::removeFile( const IndexedString &file ){
+	QMutexLocker lock( &pMutex );
+	if( ! pFilePhases.contains( file ) ){
+		return;
+	}
+	
+	setPhaseInternal( file, 0 );
+	pFilePhases.remove( file );
+	pRequestedPhases.remove( file );
+	pGeneration++;
+	
+	// removed files are no longer waited for
+	WaiterMap ready;
+	collectReadyWaiters( ready );
+	collectReadyFileWaiters( file, 3, ready );
+	lock.unlock();
+	schedule( ready );
+}
+
+void PhaseBarrier::fileFinished( const IndexedString &file, int phase ){
+	QMutexLocker lock( &pMutex );
+	if( ! pFilePhases.contains( file ) ){
+		return;
+	}
+	
+	const int oldPhase = pFilePhases.value( file );
+	setPhaseInternal( file, phase );
+	if( phase <= oldPhase ){
+		return;
+	}
+	
+	if( phase >= pRequestedPhases.value( file, 4 ) ){
+		pRequestedPhases.remove( file );
+	}
+	
+	WaiterMap ready;
+	collectReadyWaiters( ready );
+	collectReadyFileWaiters( file, phase, ready );
+	lock.unlock();
+	schedule( ready );
+}
+
+bool PhaseBarrier::reached( int phase, const IndexedString &ignore, QSet<IndexedString> *missing ){
+	QMutexLocker lock( &pMutex );
+	phase = qMin( qMax( phase, 0 ), 3 );
+	
+	if( reachedInternal( phase, ignore ) ){
+		return true;
+	}
+	
+	if( missing ){
+		QHash<IndexedString, int>::const_iterator iter;
+		for( iter = pFilePhases.cbegin(); iter != pFilePhases.cend(); iter++ ){
+			if( iter.value() < phase && iter.key() != ignore ){
+				*missing << iter.key();
+			}
+		}
+	}
+	
+	return false;
+}
+
+bool PhaseBarrier::waitFor( const IndexedString &file, int phase,
+const DelayedParsing::ScheduleParameters &parameters ){
+	QMutexLocker lock( &pMutex );
+	phase = qMin( qMax( phase, 0 ), 3 );
+	
+	if( pWaiterPhases.contains( file ) ){
+		pWaiters[ pWaiterPhases.take( file ) ].remove( file );
+	}
+	
+	if( reachedInternal( phase, file ) ){
+		return false;
+	}
+	
+	pWaiters[ phase ].insert( file, parameters );
+	pWaiterPhases.insert( file, phase );
+	return true;
+}
+
+bool PhaseBarrier::requestPhase( const IndexedString &file, int phase ){
+	QMutexLocker lock( &pMutex );
+	phase = qMin( qMax( phase, 0 ), 3 );
+	
+	if( pFilePhases.value( file ) >= phase || pRequestedPhases.value( file ) >= phase ){
+		return false;
+	}
+	
+	pRequestedPhases.insert( file, phase );
+	return true;
+}
+
+bool PhaseBarrier::waitForFiles( const IndexedString &file, const QSet<IndexedString> &files,
+int phase, const DelayedParsing::ScheduleParameters &parameters ){
+	QMutexLocker lock( &pMutex );
+	phase = qMin( qMax( phase, 0 ), 3 );
+	pFileWaiters.remove( file );
+	
+	FileWaiter waiter{ QSet<IndexedString>(), phase, parameters };
+	foreach( const IndexedString &each, files ){
+		if( pFilePhases.contains( each ) && pFilePhases.value( each ) < phase ){
+			waiter.files << each;
+		}
+	}
+	
+	if( waiter.files.isEmpty() ){
+		return false;
+	}
+	
+	pFileWaiters.insert( file, waiter );
+	return true;
+}
+
+void PhaseBarrier::cancelWaiting( const IndexedString &file ){
+	QMutexLocker lock( &pMutex );
+	if( pWaiterPhases.contains( file ) ){
+		pWaiters[ pWaiterPhases.take( file ) ].remove( file );
+	}
+	pFileWaiters.remove( file );
+}
+
+bool PhaseBarrier::isWaiting( const IndexedString &file ){
+	QMutexLocker lock( &pMutex );
+	return pWaiterPhases.contains( file ) || pFileWaiters.contains( file );
+}
+
+quint64 PhaseBarrier::generation(){
+	QMutexLocker lock( &pMutex );
+	return pGeneration;
+}
+
+
+
+bool PhaseBarrier::reachedInternal( int phase, const IndexedString &ignore ) const{
+	if( phase == 0 ){
+		return true;
+	}
+	
+	int required = pFilePhases.size();
+	const QHash<IndexedString, int>::const_iterator iterIgnore( pFilePhases.constFind( ignore ) );
+	if( iterIgnore != pFilePhases.cend() && iterIgnore.value() < phase ){
+		required--;
+	}
+	
+	return pPhaseCount[ phase ] >= required;
+}
+
+void PhaseBarrier::setPhaseInternal( const IndexedString &file, int phase ){
+	int &filePhase = pFilePhases[ file ];
+	phase = qMin( qMax( phase, 0 ), 3 );
+	if( phase != filePhase ){
+		pGeneration++;
+	}
+	
+	// counts store the number of files with phase equal or higher
+	int i;
+	for( i=filePhase+1; i<=phase; i++ ){
+		pPhaseCount[ i ]++;
+	}
+	for( i=phase+1; i<=filePhase; i++ ){
+		pPhaseCount[ i ]--;
+	}
+	
+	filePhase = phase;
+}
+
+void PhaseBarrier::collectReadyWaiters( WaiterMap &ready ){
+	int phase;
+	for( phase=1; phase<4; phase++ ){
+		// quick check. a waiter is ready if all files except itself reached the phase
+		if( pWaiters[ phase ].isEmpty() || pPhaseCount[ phase ] < pFilePhases.size() - 1 ){
+			continue;
+		}
+		
+		WaiterMap::iterator iter( pWaiters[ phase ].begin() );
+		while( iter != pWaiters[ phase ].end() ){
+			if( reachedInternal( phase, iter.key() ) ){
+				ready.insert( iter.key(), iter.value() );
+				pWaiterPhases.remove( iter.key() );
+				iter = pWaiters[ phase ].erase( iter );
+				
+			}else{
+				iter++;
+			}
+		}
+	}
+}
+
+void PhaseBarrier::collectReadyFileWaiters( const IndexedString &file, int phase, WaiterMap &ready ){
+	QHash<IndexedString, FileWaiter>::iterator iter( pFileWaiters.begin() );
+	while( iter != pFileWaiters.end() ){
+		if( phase >= iter->phase ){
+			iter->files.remove( file );
+		}
+		
+		if( iter->files.isEmpty() ){
+			ready.insert( iter.key(), iter->parameters );
+			iter = pFileWaiters.erase( iter );
+			
+		}else{
+			iter++;
+		}
+	}
+}
+
+void PhaseBarrier::schedule( const WaiterMap &waiters ){
+	if( waiters.isEmpty() ){
+		return;
+	}
+	
+	DelayedParsing &delayedParsing = DelayedParsing::self();
+	WaiterMap::const_iterator iter;
+	
+	for( iter = waiters.cbegin(); iter != waiters.cend(); iter++ ){
+		delayedParsing.schedule( iter.key(), iter.value() );
+	}
+}
+
+}
@@ -0,0 +1,141 @@
+#ifndef PHASEBARRIER_H
+#define PHASEBARRIER_H
+
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QMutex>
+
+#include <serialization/indexedstring.h>
+
+#include "DelayedParsing.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+/**
+ * Phase barrier shared by all files of a package or project.
+ * 
+ * Parsing a file in phase N requires all other files of the same package or project to
+ * have finished phase N-1. Instead of every job checking every file the barrier keeps
+ * track of the phase each file finished and counts the files per phase. Jobs finding
+ * the barrier not reached yet register themselves using \ref waitFor() and are scheduled
+ * once when the count reaches the file count.
+ * 
+ * The phase of files is unknown until they report a finished phase using
+ * \ref fileFinished(). Jobs checking the missing files report the phase of loaded
+ * contexts to bring the barrier up to date.
+ * 
+ * Files of lazy packages are parsed further only if requested by dependent files. Jobs
+ * request them using \ref requestPhase() and wait for them using \ref waitForFiles().
+ * Requests are remembered until the file reaches the requested phase. This way files
+ * failing to reach the phase are not requested over and over again.
+ * 
+ * This class uses an internal locking and is thread safe.
+ */
+class PhaseBarrier{
+public:
+	/** Reference type. */
+	typedef QSharedPointer<PhaseBarrier> Ref;
+	
+	
+	
+	/** Create empty phase barrier. */
+	PhaseBarrier();
+	
+	
+	
+	/** Files tracked by the barrier. */
+	QSet<IndexedString> files();
+	
+	/**
+	 * Set files tracked by the barrier. Phase of new files is unknown. Phase of files
+	 * present in the barrier already is kept.
+	 */
+	void setFiles( const QSet<IndexedString> &files );
+	
+	/** Add file with unknown phase if absent. */
+	void addFile( const IndexedString &file );
+	
+	/** Remove file if present. */
+	void removeFile( const IndexedString &file );
+	
+	/**
+	 * File finished \em phase. Schedules waiters if the barrier they wait for has been
+	 * reached. Phase can be lower than the one known before if the file changed.
+	 */
+	void fileFinished( const IndexedString &file, int phase );
+	
+	/**
+	 * All files except \em ignore finished \em phase or higher. If not all files finished
+	 * and \em missing is not nullptr the files below \em phase are added to it.
+	 */
+	bool reached( int phase, const IndexedString &ignore, QSet<IndexedString> *missing = nullptr );
+	
+	/**
+	 * Schedule \em file using \em parameters once all other files finished \em phase.
+	 * If the barrier is reached already nothing is registered and false is returned.
+	 * In this case the caller has to schedule the file itself.
+	 */
+	bool waitFor( const IndexedString &file, int phase,
+		const DelayedParsing::ScheduleParameters &parameters );
+	
+	/**
+	 * Request \em file to reach \em phase. Returns true if the caller has to schedule the
+	 * file. Returns false if the file reached the phase already or has been requested
+	 * to reach the phase before.
+	 */
+	bool requestPhase( const IndexedString &file, int phase );
+	
+	/**
+	 * Schedule \em file using \em parameters once all \em files tracked by the barrier
+	 * finished \em phase. If all files finished already nothing is registered and false
+	 * is returned. In this case the caller has to schedule the file itself.
+	 */
+	bool waitForFiles( const IndexedString &file, const QSet<IndexedString> &files, int phase,
+		const DelayedParsing::ScheduleParameters &parameters );
+	
+	/** Remove \em file from waiting if present. */
+	void cancelWaiting( const IndexedString &file );
+	
+	/** File is waiting for the barrier or files tracked by the barrier. */
+	bool isWaiting( const IndexedString &file );
+	
+	/**
+	 * Generation. Increments each time files are added or removed or the phase of a file
+	 * changes. Used to detect if state derived from the barrier is outdated.
+	 */
+	quint64 generation();
+	
+	
+	
+private:
+	typedef QHash<IndexedString, DelayedParsing::ScheduleParameters> WaiterMap;
+	
+	struct FileWaiter{
+		QSet<IndexedString> files;
+		int phase;
+		DelayedParsing::ScheduleParameters parameters;
+	};
+	
+	bool reachedInternal( int phase, const IndexedString &ignore ) const;
+	void setPhaseInternal( const IndexedString &file, int phase );
+	void collectReadyWaiters( WaiterMap &ready );
+	void collectReadyFileWaiters( const IndexedString &file, int phase, WaiterMap &ready );
+	static void schedule( const WaiterMap &waiters );
+	
+	QMutex pMutex;
+	QHash<IndexedString, int> pFilePhases;
+	int pPhaseCount[ 4 ];
+	WaiterMap pWaiters[ 4 ];
+	QHash<IndexedString, int> pWaiterPhases;
+	QHash<IndexedString, FileWaiter> pFileWaiters;
+	QHash<IndexedString, int> pRequestedPhases;
+	quint64 pGeneration;
+};
+
+}
+
+#endif
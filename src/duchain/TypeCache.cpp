@@ -0,0 +1,107 @@
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <language/duchain/topducontext.h>
+
+#include "TypeCache.h"
+
+
+using namespace KDevelop;
+
+namespace DragonScript {
+
+// global instance
+TypeCache TypeCache::pSelf;
+
+
+ClassDeclaration *TypeCache::declarationFor( const IndexedType &type ){
+	Entry entry;
+	{
+	QReadLocker lock( &pLock );
+	const QHash<IndexedType, Entry>::const_iterator iter( pTypes.constFind( type ) );
+	if( iter == pTypes.cend() ){
+		return nullptr;
+	}
+	entry = *iter;
+	}
+	
+	return resolve( entry );
+}
+
+ClassDeclaration *TypeCache::declarationFor( const IndexedIdentifier &identifier ){
+	Entry entry;
+	{
+	QReadLocker lock( &pLock );
+	const QHash<IndexedIdentifier, Entry>::const_iterator iter( pIdentifiers.constFind( identifier ) );
+	if( iter == pIdentifiers.cend() ){
+		return nullptr;
+	}
+	entry = *iter;
+	}
+	
+	return resolve( entry );
+}
+
+void TypeCache::add( const IndexedType &type, ClassDeclaration *declaration ){
+	if( ! declaration ){
+		return;
+	}
+	
+	const Entry entry{ IndexedDeclaration( declaration ), declaration->qualifiedIdentifier() };
+	QWriteLocker lock( &pLock );
+	pTypes.insert( type, entry );
+	pContextTypes[ entry.declaration.topContextIndex() ].insert( type );
+}
+
+void TypeCache::add( const IndexedIdentifier &identifier, ClassDeclaration *declaration ){
+	if( ! declaration ){
+		return;
+	}
+	
+	const Entry entry{ IndexedDeclaration( declaration ), declaration->qualifiedIdentifier() };
+	QWriteLocker lock( &pLock );
+	pIdentifiers.insert( identifier, entry );
+	pContextIdentifiers[ entry.declaration.topContextIndex() ].insert( identifier );
+}
+
+void TypeCache::invalidate( uint topContextIndex ){
+	QWriteLocker lock( &pLock );
+	
+	const QSet<IndexedType> types( pContextTypes.take( topContextIndex ) );
+	foreach( const IndexedType &type, types ){
+		const QHash<IndexedType, Entry>::iterator iter( pTypes.find( type ) );
+		if( iter != pTypes.end() && iter->declaration.topContextIndex() == topContextIndex ){
+			pTypes.erase( iter );
+		}
+	}
+	
+	const QSet<IndexedIdentifier> identifiers( pContextIdentifiers.take( topContextIndex ) );
+	foreach( const IndexedIdentifier &identifier, identifiers ){
+		const QHash<IndexedIdentifier, Entry>::iterator iter( pIdentifiers.find( identifier ) );
+		if( iter != pIdentifiers.end() && iter->declaration.topContextIndex() == topContextIndex ){
+			pIdentifiers.erase( iter );
+		}
+	}
+}
+
+void TypeCache::clear(){
+	QWriteLocker lock( &pLock );
+	pTypes.clear();
+	pIdentifiers.clear();
+	pContextTypes.clear();
+	pContextIdentifiers.clear();
+}
+
+
+
+ClassDeclaration *TypeCache::resolve( const Entry &entry ){
+	// the declaration index can point to a different declaration if the context has been
+	// rebuilt before the entry has been invalidated
+	ClassDeclaration * const declaration = dynamic_cast<ClassDeclaration*>( entry.declaration.declaration() );
+	if( ! declaration || declaration->qualifiedIdentifier() != entry.identifier.identifier() ){
+		return nullptr;
+	}
+	return declaration;
+}
+
+}
@@ -0,0 +1,90 @@
+#ifndef TYPECACHE_H
+#define TYPECACHE_H
+
+#include <language/duchain/classdeclaration.h>
+#include <language/duchain/indexeddeclaration.h>
+#include <language/duchain/identifier.h>
+#include <language/duchain/types/indexedtype.h>
+
+#include <QHash>
+#include <QSet>
+#include <QReadWriteLock>
+
+
+using namespace KDevelop;
+
+namespace DragonScript{
+
+/**
+ * Global type resolution cache shared by all parse jobs and completion contexts.
+ * 
+ * TypeFinder caches resolved types only for the lifetime of a job. This cache keeps the
+ * resolved class declarations across jobs. Entries are stored as IndexedDeclaration and
+ * are dropped if the top context containing the declaration is rebuilt.
+ * 
+ * Returned declarations are verified to still match the type or identifier. The caller
+ * has to verify the declaration is visible from its search contexts.
+ * 
+ * This class works as singleton and is thread safe.
+ */
+class TypeCache{
+public:
+	/** Global instance. */
+	static inline TypeCache &self(){ return pSelf; }
+	
+	
+	
+	/**
+	 * Cached class declaration for type or nullptr.
+	 * \note DUChainReadLocker required.
+	 */
+	ClassDeclaration *declarationFor( const IndexedType &type );
+	
+	/**
+	 * Cached class declaration for global identifier or nullptr.
+	 * \note DUChainReadLocker required.
+	 */
+	ClassDeclaration *declarationFor( const IndexedIdentifier &identifier );
+	
+	/**
+	 * Add class declaration for type.
+	 * \note DUChainReadLocker required.
+	 */
+	void add( const IndexedType &type, ClassDeclaration *declaration );
+	
+	/**
+	 * Add class declaration for global identifier.
+	 * \note DUChainReadLocker required.
+	 */
+	void add( const IndexedIdentifier &identifier, ClassDeclaration *declaration );
+	
+	/** Drop all entries resolving to declarations in top context. */
+	void invalidate( uint topContextIndex );
+	
+	/** Drop all entries. */
+	void clear();
+	
+	
+	
+private:
+	struct Entry{
+		IndexedDeclaration declaration;
+		IndexedQualifiedIdentifier identifier;
+	};
+	
+	TypeCache() = default;
+	
+	static ClassDeclaration *resolve( const Entry &entry );
+	
+	static TypeCache pSelf;
+	
+	QReadWriteLock pLock;
+	QHash<IndexedType, Entry> pTypes;
+	QHash<IndexedIdentifier, Entry> pIdentifiers;
+	QHash<uint, QSet<IndexedType>> pContextTypes;
+	QHash<uint, QSet<IndexedIdentifier>> pContextIdentifiers;
+};
+
+}
+
+#endif
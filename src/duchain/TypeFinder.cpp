@@ -3,8 +3,13 @@
 #include <language/duchain/types/structuretype.h>
 
 #include "TypeFinder.h"
+#include "TypeCache.h"
+#include "ClassIndex.h"
 #include "ImportPackage.h"
 #include "ImportPackageLanguage.h"
+#include "ImportPackages.h"
+#include "../DSParseJob.h"
+#include "../DSLanguageSupport.h"
 
 
 using namespace KDevelop;
@@ -103,6 +108,25 @@ ClassDeclaration *TypeFinder::declarationFor( const AbstractType::Ptr &type ){
 	}
 	
 	DUChainReadLocker lock;
+	const IndexedType indexedType( type );
+	
+	ClassDeclaration * const cachedDecl = TypeCache::self().declarationFor( indexedType );
+	if( cachedDecl && isSearchContext( cachedDecl->topContext()->ownIndex() ) ){
+		pTypeMap.insert( type, ClassDeclarationPointer( cachedDecl ) );
+		noteResolved( cachedDecl );
+		return cachedDecl;
+	}
+	
+	const IndexedQualifiedIdentifier identifier( structType->qualifiedIdentifier() );
+	foreach( ClassDeclaration * const indexDecl, ClassIndex::self().declarationsFor( identifier ) ){
+		if( isSearchContext( indexDecl->topContext()->ownIndex() ) ){
+			pTypeMap.insert( type, ClassDeclarationPointer( indexDecl ) );
+			TypeCache::self().add( indexedType, indexDecl );
+			noteResolved( indexDecl );
+			return indexDecl;
+		}
+	}
+	
 	foreach( const ReferencedTopDUContext &top, pSearchContexts ){
 		if( ! top ){
 			continue;
@@ -119,6 +143,9 @@ ClassDeclaration *TypeFinder::declarationFor( const AbstractType::Ptr &type ){
 		}
 		
 		pTypeMap.insert( type, ClassDeclarationPointer( classDecl ) );
+		TypeCache::self().add( indexedType, classDecl );
+		ClassIndex::self().add( classDecl ); // contexts loaded from the store are not indexed
+		noteResolved( classDecl );
 		return classDecl;
 	}
 	
@@ -138,6 +165,14 @@ ClassDeclaration *TypeFinder::declarationFor( const IndexedIdentifier &identifie
 	}
 	
 	DUChainReadLocker lock;
+	
+	ClassDeclaration * const cachedDecl = TypeCache::self().declarationFor( identifier );
+	if( cachedDecl && isSearchContext( cachedDecl->topContext()->ownIndex() ) ){
+		pIdentifierMap.insert( identifier, ClassDeclarationPointer( cachedDecl ) );
+		noteResolved( cachedDecl );
+		return cachedDecl;
+	}
+	
 	foreach( const ReferencedTopDUContext &top, pSearchContexts ){
 		if( ! top ){
 			continue;
@@ -154,6 +189,8 @@ ClassDeclaration *TypeFinder::declarationFor( const IndexedIdentifier &identifie
 		}
 		
 		pIdentifierMap.insert( identifier, ClassDeclarationPointer( classDecl ) );
+		TypeCache::self().add( identifier, classDecl );
+		noteResolved( classDecl );
 		return classDecl;
 	}
 	
@@ -163,6 +200,65 @@ ClassDeclaration *TypeFinder::declarationFor( const IndexedIdentifier &identifie
 
 
 
+void TypeFinder::addSearchContext( TopDUContext *context ){
+	const ReferencedTopDUContext reference( context );
+	if( ! pSearchContexts.contains( reference ) ){
+		pSearchContexts << reference;
+		pDirtySearchContextIndices = true;
+	}
+}
+
+bool TypeFinder::isSearchContext( uint topContextIndex ){
+	if( pDirtySearchContextIndices ){
+		pSearchContextIndices.clear();
+		foreach( const ReferencedTopDUContext &top, pSearchContexts ){
+			if( top ){
+				pSearchContextIndices << top->ownIndex();
+			}
+		}
+		pDirtySearchContextIndices = false;
+	}
+	
+	return pSearchContextIndices.contains( topContextIndex );
+}
+
+
+
+void TypeFinder::addLazyFiles( const QSet<IndexedString> &files ){
+	pLazyFiles.unite( files );
+}
+
+void TypeFinder::noteResolved( const ClassDeclaration *declaration ){
+	if( ! declaration ){
+		return;
+	}
+	
+	const TopDUContext * const top = declaration->topContext();
+	if( pCheckedLazyContexts.contains( top->ownIndex() ) ){
+		return;
+	}
+	pCheckedLazyContexts << top->ownIndex();
+	
+	const ImportPackage::Ref package( DSLanguageSupport::self()->importPackages().packageContaining( top->url() ) );
+	if( ! package || ! package->lazy() ){
+		return;
+	}
+	
+	if( DSParseJob::phaseFromFlags( top->features() ) < 2 ){
+		pLazyFiles << top->url();
+		return;
+	}
+	
+	// base classes are imported by the class context directly without passing through
+	// the type finder. resolve them to request their files if not fully parsed yet
+	uint i;
+	for( i=0; i<declaration->baseClassesSize(); i++ ){
+		declarationFor( declaration->baseClasses()[ i ].baseClass.abstractType() );
+	}
+}
+
+
+
 ClassDeclaration *TypeFinder::declarationForIntegral( const IndexedIdentifier &identifier ){
 	DUChainReadLocker lock;
 	
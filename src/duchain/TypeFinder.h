@@ -32,6 +32,10 @@ namespace DragonScript{
  * DUChainReadLocker locking, namely only the first time a type is encounted and needs to
  * be looked up.
  * 
+ * Types resolved by searching the contexts are stored in the global TypeCache. Other jobs
+ * encountering the same type pick the declaration up from there if it is located in one
+ * of their search contexts.
+ * 
  * \note This class locks DUChainReadLocker internally.
  */
 class TypeFinder{
@@ -57,6 +61,8 @@ public:
 	
 private:
 	TypeTopContextList pSearchContexts;
+	QSet<uint> pSearchContextIndices;
+	bool pDirtySearchContextIndices = true;
 	
 	TypeMap pTypeMap;
 	IdentifierMap pIdentifierMap;
@@ -72,6 +78,9 @@ private:
 	
 	QSet<TopDUContextPointer> pLangClasses;
 	
+	QSet<uint> pCheckedLazyContexts;
+	QSet<IndexedString> pLazyFiles;
+	
 	
 	
 public:
@@ -83,10 +92,16 @@ public:
 	inline const TypeTopContextList &searchContexts() const{ return pSearchContexts; }
 	
 	/**
-	 * Set search contexts.
+	 * Add search context.
 	 * \note Requires DUChainWriteLocker.
 	 */
-	inline TypeTopContextList &searchContexts(){ return pSearchContexts; }
+	void addSearchContext( TopDUContext *context );
+	
+	/**
+	 * Top context with index is a search context.
+	 * \note DUChainReadLocker required.
+	 */
+	bool isSearchContext( uint topContextIndex );
 	
 	
 	
@@ -123,6 +138,25 @@ public:
 	
 	
 	
+	/**
+	 * Files of lazy packages declaring resolved classes which are not fully parsed yet.
+	 * Members of these classes are not known until the files are parsed.
+	 */
+	inline const QSet<IndexedString> &lazyFiles() const{ return pLazyFiles; }
+	
+	/** Add lazy files noted by another type finder. */
+	void addLazyFiles( const QSet<IndexedString> &files );
+	
+	/**
+	 * Note resolved class declaration. If the declaration is located in a lazy package
+	 * file not fully parsed yet the file is added to the lazy files. Base classes of
+	 * fully parsed lazy package classes are noted too.
+	 * \note DUChainReadLocker required.
+	 */
+	void noteResolved( const ClassDeclaration *declaration );
+	
+	
+	
 protected:
 	ClassDeclaration *declarationForIntegral( const IndexedIdentifier &identifier );
 };
@@ -1,4 +1,8 @@
 #include <QDebug>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 #include <language/duchain/declaration.h>
 #include <language/duchain/use.h>
@@ -30,12 +34,18 @@ pEnableErrorReporting( true ),
 pAllowVoidType( false ),
 pCanBeType( true ),
 pAutoThis( true ),
-pIgnoreVariable( nullptr )
+pIgnoreVariable( nullptr ),
+pClassContext( nullptr ),
+pParallelFunctionBodies( false )
 {
 	setDependencies( deps );
 	setEditor( &editor );
 	setTypeFinder( &typeFinderr );
 	setRootNamespace( namespaceRef );
+	
+	// uses and problems are collected while visiting and committed afterwards under one
+	// short write lock. visiting only requires a read lock
+	batchLock().setReadOnly( true );
 }
 
 
@@ -44,12 +54,295 @@ void UseBuilder::setEnableErrorReporting( bool enable ){
 	pEnableErrorReporting = enable;
 }
 
+void UseBuilder::setParallelFunctionBodies( bool parallel ){
+	pParallelFunctionBodies = parallel;
+}
+
+
+
+/**
+ * Builds deferred function bodies. Each worker uses an own type finder and namespace
+ * tree since these are not thread safe. Workers pull the next function body to build
+ * from a shared counter.
+ */
+class UseBuilder::FunctionBodyWorker : public QRunnable{
+public:
+	FunctionBodyWorker( UseBuilder &owner, QAtomicInt &nextBody );
+	void run() override;
+	
+	UseBuilder &pOwner;
+	QAtomicInt &pNextBody;
+	TypeFinder pTypeFinder;
+	Namespace::Ref pRootNamespace;
+	UseBuilder pBuilder;
+};
+
+UseBuilder::FunctionBodyWorker::FunctionBodyWorker( UseBuilder &owner, QAtomicInt &nextBody ) :
+pOwner( owner ),
+pNextBody( nextBody ),
+pTypeFinder( *owner.typeFinder() ),
+pBuilder( *owner.editor(), owner.dependencies(), pTypeFinder, pRootNamespace )
+{
+	setAutoDelete( false );
+	pBuilder.pEnableErrorReporting = owner.pEnableErrorReporting;
+	pBuilder.setExpressionMemo( owner.expressionMemo() );
+}
+
+void UseBuilder::FunctionBodyWorker::run(){
+	{
+	DUChainReadLocker lock;
+	pRootNamespace = Namespace::Ref( new Namespace( pTypeFinder ) );
+	}
+	pBuilder.setCurNamespace( pRootNamespace.data() );
+	
+	const QVector<FunctionBody> &bodies = pOwner.pFunctionBodies;
+	while( true ){
+		const int index = pNextBody.fetchAndAddRelaxed( 1 );
+		if( index >= bodies.size() ){
+			break;
+		}
+		pBuilder.buildFunctionBody( bodies.at( index ) );
+	}
+}
+
+
+
+void UseBuilder::buildFunction( const ReferencedTopDUContext &top, StartAst *start,
+ClassBodyDeclarationAst *node ){
+	if( ! node->function || ! prepareBuild() ){
+		return;
+	}
+	
+	DUContext * const functionContext = contextFromNode( functionContextNode( node->function ) );
+	if( ! functionContext ){
+		return;
+	}
+	
+	batchLock().lock();
+	
+	restoreNamespaces( start, node );
+	
+	const int openedCount = openParentContexts( functionContext->parentContext() );
+	visitNode( node->function );
+	
+	// closing parent contexts takes a write lock
+	batchLock().unlock();
+	closeParentContexts( openedCount );
+	
+	DUChainWriteLocker lock;
+	
+	// uses in the class context belong to the unchanged function declaration and are kept
+	QSet<DUContext*> contexts;
+	
+	foreach( DUContext *each, pCollectedContexts ){
+		each->deleteUses();
+		contexts << each;
+	}
+	foreach( const CollectedUse &each, pCollectedUses ){
+		if( each.declaration && contexts.contains( each.context ) ){
+			each.context->createUse( top->indexForUsedDeclaration( each.declaration.data() ), each.range );
+		}
+	}
+	foreach( const ProblemPointer &each, pCollectedProblems ){
+		top->addProblem( each );
+	}
+	lock.unlock();
+	
+	pCollectedUses.clear();
+	pCollectedProblems.clear();
+	pCollectedContexts.clear();
+}
+
+
+
+void UseBuilder::startVisiting( AstNode *node ){
+	UseBuilderBase::startVisiting( node );
+	
+	QVector<FunctionBodyWorker*> workers;
+	if( ! pFunctionBodies.isEmpty() ){
+		workers = buildFunctionBodies();
+	}
+	
+	commitCollected( workers );
+	qDeleteAll( workers );
+}
+
+void UseBuilder::openContext( DUContext *newContext ){
+	// the base classes take a write lock while closing contexts. collected contexts
+	// are only pushed since they are neither compiled nor tracked for uses
+	contextStack().push( newContext );
+	pCollectedContexts << newContext;
+}
+
+void UseBuilder::closeContext(){
+	contextStack().pop();
+}
+
+bool UseBuilder::openNodeContext( AstNode *node ){
+	DUContext * const context = contextFromNode( node );
+	if( ! context ){
+		return false;
+	}
+	
+	openContext( context );
+	return true;
+}
+
+void UseBuilder::yieldBatchLock(){
+	// overloads point into other top contexts which can change while the lock is released
+	if( batchLock().yield() ){
+		pOverloadIndex.clear();
+	}
+}
+
+void UseBuilder::visitStatementSequence( const KDevPG::ListNode<StatementAst*> *sequence ){
+	if( ! sequence ){
+		return;
+	}
+	
+	const KDevPG::ListNode<StatementAst*> *iter = sequence->front();
+	const KDevPG::ListNode<StatementAst*> *end = iter;
+	const bool opened = openNodeContext( iter->element );
+	
+	do{
+		yieldBatchLock();
+		visitNode( iter->element );
+		iter = iter->next;
+	}while( iter != end );
+	
+	if( opened ){
+		closeContext();
+	}
+}
+
+AstNode *UseBuilder::functionContextNode( ClassFunctionDeclareAst *node ){
+	// function context starts at the first argument or behind the function name
+	if( node->begin->argumentsSequence ){
+		return node->begin->argumentsSequence->front()->element;
+	}
+	return node;
+}
+
+void UseBuilder::newUse( AstNode *node, const DeclarationPointer &declaration ){
+	newUse( editorFindRange( node, node ), declaration );
+}
+
+void UseBuilder::newUse( const RangeInRevision &range, const DeclarationPointer &declaration ){
+	if( ! declaration ){
+		return;
+	}
+	
+	// same as the base class the use is added to the first context containing it. workers
+	// open only the function context hence continue with the parent contexts
+	const QStack<DUContext*> &stack = contextStack();
+	int index = stack.size() - 1;
+	
+	DUChainReadLocker lock;
+	while( index > 0 && ! stack.at( index )->range().contains( range ) ){
+		index--;
+	}
+	
+	DUContext *context = stack.at( index );
+	while( context->parentContext() && ! context->range().contains( range ) ){
+		context = context->parentContext();
+	}
+	
+	CollectedUse use;
+	use.context = context;
+	use.range = range;
+	use.declaration = declaration;
+	pCollectedUses << use;
+}
+
+QVector<UseBuilder::FunctionBodyWorker*> UseBuilder::buildFunctionBodies(){
+	const int workerCount = qMax( qMin( QThread::idealThreadCount(),
+		pFunctionBodies.size() / minFunctionBodiesPerWorker ), 1 );
+	
+	QAtomicInt nextBody( 0 );
+	QVector<FunctionBodyWorker*> workers;
+	int i;
+	
+	{
+	DUChainWriteLocker lock; // type finder copies reference search contexts
+	for( i=0; i<workerCount; i++ ){
+		workers << new FunctionBodyWorker( *this, nextBody );
+	}
+	}
+	
+	// the calling thread runs the first worker itself
+	QThreadPool pool;
+	pool.setMaxThreadCount( qMax( workerCount - 1, 1 ) );
+	for( i=1; i<workerCount; i++ ){
+		pool.start( workers.at( i ) );
+	}
+	workers.at( 0 )->run();
+	pool.waitForDone();
+	
+	pFunctionBodies.clear();
+	return workers;
+}
 
+void UseBuilder::commitCollected( const QVector<FunctionBodyWorker*> &workers ){
+	QVector<UseBuilder*> builders;
+	builders << this;
+	foreach( FunctionBodyWorker *worker, workers ){
+		builders << &worker->pBuilder;
+	}
+	
+	DUChainWriteLocker lock;
+	TopDUContext * const top = topContext();
+	
+	// workers add uses to contexts collected by this builder. remove old uses from all
+	// contexts first
+	foreach( UseBuilder *builder, builders ){
+		foreach( DUContext *each, builder->pCollectedContexts ){
+			each->deleteUses();
+		}
+	}
+	
+	foreach( UseBuilder *builder, builders ){
+		foreach( const CollectedUse &each, builder->pCollectedUses ){
+			// declarations can be gone since they have been collected
+			if( each.declaration ){
+				each.context->createUse( top->indexForUsedDeclaration( each.declaration.data() ), each.range );
+			}
+		}
+		foreach( const ProblemPointer &each, builder->pCollectedProblems ){
+			top->addProblem( each );
+		}
+	}
+	
+	foreach( FunctionBodyWorker *worker, workers ){
+		typeFinder()->addLazyFiles( worker->pTypeFinder.lazyFiles() );
+	}
+	
+	pCollectedUses.clear();
+	pCollectedProblems.clear();
+	pCollectedContexts.clear();
+}
 
-DUContext *UseBuilder::contextAtOrCurrent( const CursorInRevision &pos ){
+void UseBuilder::buildFunctionBody( const FunctionBody &body ){
+	DUContext * const functionContext = contextFromNode( functionContextNode( body.node ) );
+	if( ! functionContext ){
+		return;
+	}
+	
+	// workers hold no batch lock. the read lock keeps the overloads valid while the body
+	// is built. they are dropped afterwards since other bodies run in unlocked gaps
 	DUChainReadLocker lock;
-	DUContext * const context = topContext()->findContextAt( pos, true );
-	return context ? context : currentContext();
+	pOverloadIndex.clear();
+	
+	searchNamespaces().clear();
+	foreach( const IndexedQualifiedIdentifier &each, body.searchNamespaces ){
+		searchNamespaces() << rootNamespace()->getOrAddNamespace( each.identifier() );
+	}
+	
+	// the function context is finished by the parent builder
+	contextStack().push( functionContext );
+	visitStatementSequence( body.node->bodySequence );
+	contextStack().pop();
+	
+	pOverloadIndex.clear();
 }
 
 
@@ -58,7 +351,35 @@ void UseBuilder::visitFullyQualifiedClassname( FullyQualifiedClassnameAst *node
 		return;
 	}
 	
-	DUContext *context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext *context = currentContext();
+	
+	// single type names are usually resolved already by the declaration builder
+	if( context && expressionMemo() && node->nameSequence->count() == 1 ){
+		ExpressionMemo::Entry entry;
+		bool found;
+		{
+		DUChainReadLocker lock;
+		found = expressionMemo()->find( *node, context, pAllowVoidType, entry ) && entry.declaration;
+		if( found ){
+			context = entry.declaration->internalContext();
+			if( context && context->owner() ){
+				pCurExprContext = context;
+				pCurExprType = context->owner()->abstractType();
+					
+			}else{
+				pCurExprContext = nullptr;
+				pCurExprType = Helpers::getTypeInvalid();
+			}
+		}
+		}
+		
+		if( found ){
+			newUse( node->nameSequence->front()->element, entry.declaration );
+			pCanBeType = true;
+			pAutoThis = false;
+			return;
+		}
+	}
 	
 	const KDevPG::ListNode<IdentifierAst*> *iter = node->nameSequence->front();
 	const KDevPG::ListNode<IdentifierAst*> *end = iter;
@@ -93,7 +414,7 @@ void UseBuilder::visitFullyQualifiedClassname( FullyQualifiedClassnameAst *node
 				}
 			}
 			
-			UseBuilderBase::newUse( iter->element, DeclarationPointer( decl ) );
+			newUse( iter->element, DeclarationPointer( decl ) );
 			
 			context =  nullptr;
 			if( decl ){
@@ -140,6 +461,8 @@ void UseBuilder::visitPin( PinAst *node ){
 }
 
 void UseBuilder::visitNamespace( NamespaceAst *node ){
+	closeNamespaceContexts();
+	
 	if( ! node->name->nameSequence ){
 		return;
 	}
@@ -153,15 +476,53 @@ void UseBuilder::visitNamespace( NamespaceAst *node ){
 	
 	do{
 		setCurNamespace( &curNamespace()->getOrAddNamespace( editor()->tokenText( *iter->element ) ) );
+		openNamespaceContext( iter->element );
 		iter = iter->next;
 	}while( iter != end );
 	
 	updateSearchNamespaces();
 }
 
-void UseBuilder::visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *node ){
-	const DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+void UseBuilder::visitClass( ClassAst *node ){
+	const bool opened = openNodeContext( node );
+	
+	UseBuilderBase::visitClass( node );
+	
+	if( opened ){
+		closeContext();
+	}
+}
+
+void UseBuilder::visitClassFunctionDeclare( ClassFunctionDeclareAst *node ){
+	yieldBatchLock();
+	
+	// this/super constructor lookup uses the class context. the function context is
+	// not opened if the declaration builder did not create one
+	pClassContext = currentContext();
+	const bool opened = openNodeContext( functionContextNode( node ) );
 	
+	visitNode( node->begin );
+	
+	if( pParallelFunctionBodies && node->bodySequence ){
+		FunctionBody body;
+		body.node = node;
+		foreach( const Namespace *each, searchNamespaces() ){
+			body.searchNamespaces << each->qualifiedIdentifier();
+		}
+		pFunctionBodies << body;
+		
+	}else{
+		visitStatementSequence( node->bodySequence );
+	}
+	
+	visitNode( node->end );
+	
+	if( opened ){
+		closeContext();
+	}
+}
+
+void UseBuilder::visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *node ){
 	// overwritten to allow void type in FullyQualifiedClassnameAst
 	pAllowVoidType = true;
 	visitNode( node->type );
@@ -185,7 +546,7 @@ void UseBuilder::visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *n
 	
 	// find this/super class constructors
 	const RangeInRevision useRange( editor()->findRange( node->super ) );
-	const DUContext *searchContext = context->parentContext();
+	const DUContext *searchContext = pClassContext;
 	QVector<Declaration*> declarations;
 	
 	DUChainReadLocker lock;
@@ -270,7 +631,7 @@ void UseBuilder::visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *n
 			}
 			sig.append( ")" );
 			
-			const ClassDeclaration * const classDecl = Helpers::classDeclFor( context );
+			const ClassDeclaration * const classDecl = Helpers::classDeclFor( pClassContext );
 			lock.unlock();
 			
 			if( classDecl ){
@@ -293,7 +654,7 @@ void UseBuilder::visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *n
 	// use function if found. no context required since this is outside function block
 	if( useFunction ){
 		//UseBuilderBase::newUse( node->name, useRange, DeclarationPointer( useFunction ) );
-		UseBuilderBase::newUse( useRange, DeclarationPointer( useFunction ) );
+		newUse( useRange, DeclarationPointer( useFunction ) );
 		
 	}else{
 		const char *separator = "";
@@ -305,7 +666,7 @@ void UseBuilder::visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *n
 		sig.append( ")" );
 		
 		lock.lock();
-		const ClassDeclaration * const classDecl = Helpers::classDeclFor( context );
+		const ClassDeclaration * const classDecl = Helpers::classDeclFor( pClassContext );
 		lock.unlock();
 		
 		if( classDecl ){
@@ -319,7 +680,7 @@ void UseBuilder::visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *n
 }
 
 void UseBuilder::visitClassVariablesDeclare( ClassVariablesDeclareAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	const AbstractType::Ptr type( typeOfNode( node->type, context ) );
 	
 	if( ! node->variablesSequence ){
@@ -357,8 +718,38 @@ void UseBuilder::visitClassVariablesDeclare( ClassVariablesDeclareAst *node ){
 
 
 
+void UseBuilder::visitInterface( InterfaceAst *node ){
+	const bool opened = openNodeContext( node );
+	
+	UseBuilderBase::visitInterface( node );
+	
+	if( opened ){
+		closeContext();
+	}
+}
+
+void UseBuilder::visitInterfaceFunctionDeclare( InterfaceFunctionDeclareAst *node ){
+	const bool opened = openNodeContext( node );
+	
+	UseBuilderBase::visitInterfaceFunctionDeclare( node );
+	
+	if( opened ){
+		closeContext();
+	}
+}
+
+void UseBuilder::visitEnumeration( EnumerationAst *node ){
+	const bool opened = openNodeContext( node );
+	
+	UseBuilderBase::visitEnumeration( node );
+	
+	if( opened ){
+		closeContext();
+	}
+}
+
 void UseBuilder::visitExpression( ExpressionAst *node ){
-	pCurExprContext = contextAtOrCurrent( editor()->findPosition( *node ) );
+	pCurExprContext = currentContext();
 	pCurExprType = nullptr;
 	pCanBeType = true;
 	pAutoThis = true;
@@ -367,7 +758,7 @@ void UseBuilder::visitExpression( ExpressionAst *node ){
 }
 
 void UseBuilder::visitExpressionConstant( ExpressionConstantAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	
 	const QString name( editor()->tokenText( *node ) );
 	const RangeInRevision useRange( editor()->findRange( *node ) );
@@ -378,6 +769,7 @@ void UseBuilder::visitExpressionConstant( ExpressionConstantAst *node ){
 	DUChainReadLocker lock;
 	ExpressionVisitor exprValue( *editor(), context, searchNamespaces(),
 		*typeFinder(), *rootNamespace() );
+	exprValue.setExpressionMemo( expressionMemo() );
 	exprValue.visitNode( node );
 	declaration = exprValue.lastDeclaration();
 	type = exprValue.lastType();
@@ -389,7 +781,7 @@ void UseBuilder::visitExpressionConstant( ExpressionConstantAst *node ){
 		case TokenTypeWrapper::TokenType::Token_THIS:
 		case TokenTypeWrapper::TokenType::Token_SUPER:
 			//UseBuilderBase::newUse( node, useRange, declaration );
-			UseBuilderBase::newUse( useRange, declaration );
+			newUse( useRange, declaration );
 			break;
 		}
 	}
@@ -503,7 +895,7 @@ void UseBuilder::visitExpressionMember( ExpressionMemberAst *node ){
 		lock.unlock();
 		
 		//UseBuilderBase::newUse( node->name, useRange, DeclarationPointer( declaration ) );
-		UseBuilderBase::newUse( useRange, DeclarationPointer( declaration ) );
+		newUse( useRange, DeclarationPointer( declaration ) );
 		
 		pCurExprType = declaration->abstractType();
 		pCurExprContext = typeFinder()->contextFor( pCurExprType );
@@ -513,8 +905,14 @@ void UseBuilder::visitExpressionMember( ExpressionMemberAst *node ){
 }
 
 void UseBuilder::visitExpressionBlock( ExpressionBlockAst *node ){
+	const bool opened = openNodeContext( node );
+	
 	UseBuilderBase::visitExpressionBlock( node );
 	
+	if( opened ){
+		closeContext();
+	}
+	
 	ClassDeclaration * const typeBlock = typeFinder()->typeBlock();
 	if( typeBlock ){
 		pCurExprContext = typeBlock->internalContext();
@@ -529,7 +927,7 @@ void UseBuilder::visitExpressionBlock( ExpressionBlockAst *node ){
 }
 
 void UseBuilder::visitExpressionAddition( ExpressionAdditionAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	DUContext *contextLeft = functionGetContext( node->left, context );
 	
 	if( ! node->moreSequence ){
@@ -549,7 +947,7 @@ void UseBuilder::visitExpressionAddition( ExpressionAdditionAst *node ){
 }
 
 void UseBuilder::visitExpressionAssign( ExpressionAssignAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	DUContext *contextLeft = functionGetContext( node->left, context );
 	
 	if( ! node->moreSequence ){
@@ -590,7 +988,7 @@ void UseBuilder::visitExpressionAssign( ExpressionAssignAst *node ){
 }
 
 void UseBuilder::visitExpressionBitOperation( ExpressionBitOperationAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	DUContext *contextLeft = functionGetContext( node->left, context );
 	
 	if( ! node->moreSequence ){
@@ -610,7 +1008,7 @@ void UseBuilder::visitExpressionBitOperation( ExpressionBitOperationAst *node ){
 }
 
 void UseBuilder::visitExpressionCompare( ExpressionCompareAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	DUContext *contextLeft = functionGetContext( node->left, context );
 	
 	if( ! node->moreSequence ){
@@ -669,7 +1067,7 @@ void UseBuilder::visitExpressionCompare( ExpressionCompareAst *node ){
 }
 
 void UseBuilder::visitExpressionLogic( ExpressionLogicAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	AbstractType::Ptr typeExpr( typeOfNode( node->left, context ) );
 	
 	if( ! node->moreSequence ){
@@ -717,7 +1115,7 @@ void UseBuilder::visitExpressionLogic( ExpressionLogicAst *node ){
 }
 
 void UseBuilder::visitExpressionMultiply( ExpressionMultiplyAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	DUContext *contextLeft = functionGetContext( node->left, context );
 	
 	if( ! node->moreSequence ){
@@ -736,7 +1134,7 @@ void UseBuilder::visitExpressionMultiply( ExpressionMultiplyAst *node ){
 }
 
 void UseBuilder::visitExpressionPostfix( ExpressionPostfixAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
  	DUContext *contextLeft = functionGetContext( node->left, context );
 	
 	if( ! node->opSequence ){
@@ -755,7 +1153,7 @@ void UseBuilder::visitExpressionPostfix( ExpressionPostfixAst *node ){
 }
 
 void UseBuilder::visitExpressionSpecial( ExpressionSpecialAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	( void )typeOfNode( node->left, context );
 	
 	if( ! node->moreSequence ){
@@ -783,6 +1181,7 @@ void UseBuilder::visitExpressionSpecial( ExpressionSpecialAst *node ){
 					DUChainReadLocker lock;
 					ExpressionVisitor exprValue( *editor(), context, searchNamespaces(),
 						*typeFinder(), *rootNamespace() );
+					exprValue.setExpressionMemo( expressionMemo() );
 					exprValue.visitNode( iter->element->type );
 					const DeclarationPointer declaration( exprValue.lastDeclaration() );
 					if( declaration ){
@@ -815,7 +1214,7 @@ void UseBuilder::visitExpressionSpecial( ExpressionSpecialAst *node ){
 }
 
 void UseBuilder::visitExpressionUnary( ExpressionUnaryAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	DUContext *contextRight = functionGetContext( node->right, context );
 	
 	if( ! node->opSequence ){
@@ -861,7 +1260,7 @@ void UseBuilder::visitExpressionUnary( ExpressionUnaryAst *node ){
 }
 
 void UseBuilder::visitExpressionInlineIfElse( ExpressionInlineIfElseAst *node ){
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	AbstractType::Ptr typeCondition( typeOfNode( node->condition, context ) );
 	
 	if( ! node->more ){
@@ -873,18 +1272,18 @@ void UseBuilder::visitExpressionInlineIfElse( ExpressionInlineIfElseAst *node ){
 	
 	bool validCondition = true, validCast = true;
 	{
-	DUChainReadLocker lock;
-	
-	validCondition = Helpers::equalsInternal( typeCondition, Helpers::getTypeBool() );
-	
-	if( node->more->expressionIf && node->more->expressionElse ){
-		validCast = Helpers::castable( typeElse, typeIf, *typeFinder() );
-	}
-	
-	pCurExprContext = typeFinder()->contextFor( typeIf );
-	pCurExprType = typeIf;
-	pCanBeType = false;
-	pAutoThis = false;
+		DUChainReadLocker lock;
+
+		validCondition = Helpers::equalsInternal( typeCondition, Helpers::getTypeBool() );
+
+		if( node->more->expressionIf && node->more->expressionElse ){
+			validCast = Helpers::castable( typeElse, typeIf, *typeFinder() );
+		}
+
+		pCurExprContext = typeFinder()->contextFor( typeIf );
+		pCurExprType = typeIf;
+		pCanBeType = false;
+		pAutoThis = false;
 	}
 	
 	if( ! validCondition ){
@@ -898,15 +1297,97 @@ void UseBuilder::visitExpressionInlineIfElse( ExpressionInlineIfElseAst *node ){
 	}
 }
 
+void UseBuilder::visitStatementIf( StatementIfAst *node ){
+	visitNode( node->condition );
+	visitStatementSequence( node->bodySequence );
+	
+	if( node->elifSequence ){
+		const KDevPG::ListNode<StatementElifAst*> *iter = node->elifSequence->front();
+		const KDevPG::ListNode<StatementElifAst*> *end = iter;
+		do{
+			visitNode( iter->element );
+			iter = iter->next;
+		}while( iter != end );
+	}
+	
+	visitStatementSequence( node->elseSequence );
+}
+
+void UseBuilder::visitStatementElif( StatementElifAst *node ){
+	visitNode( node->condition );
+	visitStatementSequence( node->bodySequence );
+}
+
+void UseBuilder::visitStatementSelect( StatementSelectAst *node ){
+	visitNode( node->value );
+	
+	if( node->caseSequence ){
+		const KDevPG::ListNode<StatementCaseAst*> *iter = node->caseSequence->front();
+		const KDevPG::ListNode<StatementCaseAst*> *end = iter;
+		do{
+			visitNode( iter->element );
+			iter = iter->next;
+		}while( iter != end );
+	}
+	
+	visitStatementSequence( node->elseSequence );
+}
+
+void UseBuilder::visitStatementCase( StatementCaseAst *node ){
+	if( node->matchesSequence ){
+		const KDevPG::ListNode<ExpressionAst*> *iter = node->matchesSequence->front();
+		const KDevPG::ListNode<ExpressionAst*> *end = iter;
+		do{
+			visitNode( iter->element );
+			iter = iter->next;
+		}while( iter != end );
+	}
+	
+	visitStatementSequence( node->bodySequence );
+}
+
 void UseBuilder::visitStatementFor( StatementForAst *node ){
 	// variable is ExpressionObjectAst. we need to manually clear the search context
 	// as if ExpressionAst would be used.
-	pCurExprContext = contextAtOrCurrent( editor()->findPosition( *node ) );
+	pCurExprContext = currentContext();
 	pCurExprType = nullptr;
 	pCanBeType = false;
 	pAutoThis = false;
 	
-	UseBuilderBase::visitStatementFor( node );
+	visitNode( node->variable );
+	visitNode( node->from );
+	visitNode( node->to );
+	visitNode( node->downto );
+	visitNode( node->step );
+	visitStatementSequence( node->bodySequence );
+}
+
+void UseBuilder::visitStatementWhile( StatementWhileAst *node ){
+	visitNode( node->condition );
+	visitStatementSequence( node->bodySequence );
+}
+
+void UseBuilder::visitStatementTry( StatementTryAst *node ){
+	visitStatementSequence( node->bodySequence );
+	
+	if( node->catchesSequence ){
+		const KDevPG::ListNode<StatementCatchAst*> *iter = node->catchesSequence->front();
+		const KDevPG::ListNode<StatementCatchAst*> *end = iter;
+		do{
+			visitNode( iter->element );
+			iter = iter->next;
+		}while( iter != end );
+	}
+}
+
+void UseBuilder::visitStatementCatch( StatementCatchAst *node ){
+	const bool opened = openNodeContext( node );
+	
+	UseBuilderBase::visitStatementCatch( node );
+	
+	if( opened ){
+		closeContext();
+	}
 }
 
 void UseBuilder::visitStatementVariableDefinitions( StatementVariableDefinitionsAst *node ){
@@ -914,7 +1395,7 @@ void UseBuilder::visitStatementVariableDefinitions( StatementVariableDefinitions
 	
 // 	UseBuilderBase::visitStatementVariableDefinitions( node );
 	
-	DUContext * const context = contextAtOrCurrent( editor()->findPosition( *node ) );
+	DUContext * const context = currentContext();
 	const AbstractType::Ptr type( typeOfNode( node->type, context ) );
 	
 	if( ! node->variablesSequence ){
@@ -993,24 +1474,27 @@ void UseBuilder::checkFunctionCall( AstNode *node, DUContext *context, const QVe
 	const IndexedIdentifier identifier( Identifier( editor()->tokenText( *node ) ) );
 	const RangeInRevision useRange( editor()->findRange( *node ) );
 	
-	QVector<Declaration*> declarations;
+	// overload sets are looked up once per context and name. calls only touch the
+	// functions with matching argument count
+	OverloadIndex::OverloadSet overloads;
 	if( context ){
 		DUChainReadLocker lock;
-		
-		if( identifier == Helpers::nameConstructor() ){
-			// constructors are only looked up in the current class
-			const ClassDeclaration * const classDecl = Helpers::thisClassDeclFor( *context );
-			if( classDecl && classDecl->internalContext() ){
-				declarations = Helpers::constructorsInClass( *classDecl->internalContext() );
+		overloads = pOverloadIndex.overloads( *context, identifier, [ & ](){
+			if( identifier == Helpers::nameConstructor() ){
+				// constructors are only looked up in the current class
+				const ClassDeclaration * const classDecl = Helpers::thisClassDeclFor( *context );
+				if( classDecl && classDecl->internalContext() ){
+					return Helpers::constructorsInClass( *classDecl->internalContext() );
+				}
+				return QVector<Declaration*>();
 			}
 			
-		}else{
-			declarations = Helpers::declarationsForName( identifier, CursorInRevision::invalid(),
+			return Helpers::declarationsForName( identifier, CursorInRevision::invalid(),
 				*context, {}, *typeFinder(), *rootNamespace(), true, false );
-		}
+		} );
 	}
 	
-	if( declarations.isEmpty() ){
+	if( overloads.declarationCount == 0 ){
 		DUChainReadLocker lock;
 		const ClassDeclaration * const classDecl = Helpers::classDeclFor( context );
 		lock.unlock();
@@ -1034,7 +1518,7 @@ void UseBuilder::checkFunctionCall( AstNode *node, DUContext *context, const QVe
 	}
 	
 	// if the first found declaration is not a function definition something is wrong
-	if( ! dynamic_cast<ClassFunctionDeclaration*>( declarations.at( 0 ) ) ){
+	if( ! overloads.firstIsFunction ){
 		DUChainReadLocker lock;
 		const ClassDeclaration * const classDecl = Helpers::classDeclFor( context );
 		lock.unlock();
@@ -1054,13 +1538,14 @@ void UseBuilder::checkFunctionCall( AstNode *node, DUContext *context, const QVe
 	}
 	
 	// find best matching function
-	ClassFunctionDeclaration *useFunction = Helpers::bestMatchingFunction( signature, declarations );
+	const OverloadIndex::CandidateList candidates( overloads.candidates( signature.size() ) );
+	ClassFunctionDeclaration *useFunction = Helpers::bestMatchingFunction( signature, candidates );
 	
 	DUChainReadLocker lock;
 	if( ! useFunction ){
 		// find functions matching with auto-casting
 		const QVector<ClassFunctionDeclaration*> possibleFunctions(
-			Helpers::autoCastableFunctions( signature, declarations, *typeFinder() ) );
+			Helpers::autoCastableFunctions( signature, candidates, *typeFinder() ) );
 		
 		if( possibleFunctions.size() == 1 ){
 			useFunction = possibleFunctions.at( 0 );
@@ -1112,7 +1597,7 @@ void UseBuilder::checkFunctionCall( AstNode *node, DUContext *context, const QVe
 	if( useFunction ){
 		lock.unlock();
 		//UseBuilderBase::newUse( node, useRange, DeclarationPointer( useFunction ) );
-		UseBuilderBase::newUse( useRange, DeclarationPointer( useFunction ) );
+		newUse( useRange, DeclarationPointer( useFunction ) );
 		
 		pCurExprType = useFunction->type<FunctionType>()->returnType();
 		if( pCurExprType ){
@@ -1163,8 +1648,7 @@ const QVector<IProblem::Ptr> &diagnostics ){
 	problem->setDescription( hint );
 	problem->setDiagnostics( diagnostics );
 	
-	DUChainWriteLocker lock;
-	topContext()->addProblem( ProblemPointer( problem ) );
+	addProblem( problem );
 // 	qDebug() << "reportSemanticError" << problem->toString();
 }
 
@@ -1179,9 +1663,12 @@ void UseBuilder::reportSemanticHint( const RangeInRevision &range, const QString
 	problem->setSeverity( IProblem::Hint );
 	problem->setDescription( hint );
 	
-	DUChainWriteLocker lock;
-	topContext()->addProblem( ProblemPointer( problem ) );
+	addProblem( problem );
 // 	qDebug() << "reportSemanticHint" << problem->toString();
 }
 
+void UseBuilder::addProblem( Problem *problem ){
+	pCollectedProblems << ProblemPointer( problem );
+}
+
 }
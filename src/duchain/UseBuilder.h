@@ -3,11 +3,13 @@
 
 #include <QStack>
 #include <language/duchain/builders/abstractusebuilder.h>
+#include <language/duchain/problem.h>
 
 #include "duchainexport.h"
 #include "dsp_ast.h"
 #include "ContextBuilder.h"
 #include "EditorIntegrator.h"
+#include "OverloadIndex.h"
 
 
 using namespace KDevelop;
@@ -19,7 +21,28 @@ class ParseSession;
 typedef AbstractUseBuilder<AstNode, Identifier, ContextBuilder> UseBuilderBase;
 
 class KDEVDSDUCHAIN_EXPORT UseBuilder : public UseBuilderBase{
+public:
+	/** Minimum number of function bodies per worker for parallel building. */
+	static const int minFunctionBodiesPerWorker = 8;
+	
+	
+	
 private:
+	class FunctionBodyWorker;
+	
+	/** Function body deferred for parallel building. */
+	struct FunctionBody{
+		ClassFunctionDeclareAst *node;
+		QVector<IndexedQualifiedIdentifier> searchNamespaces;
+	};
+	
+	/** Use collected while building. */
+	struct CollectedUse{
+		DUContext *context;
+		RangeInRevision range;
+		DeclarationPointer declaration;
+	};
+	
 	ParseSession &pParseSession;
 	DUContext *pCurExprContext;
 	AbstractType::Ptr pCurExprType;
@@ -28,6 +51,14 @@ private:
 	bool pCanBeType;
 	bool pAutoThis;
 	Declaration *pIgnoreVariable;
+	const DUContext *pClassContext;
+	OverloadIndex pOverloadIndex;
+	
+	bool pParallelFunctionBodies;
+	QVector<FunctionBody> pFunctionBodies;
+	QVector<CollectedUse> pCollectedUses;
+	QVector<ProblemPointer> pCollectedProblems;
+	QVector<DUContext*> pCollectedContexts;
 	
 	
 	
@@ -44,14 +75,40 @@ public:
 	/** Set if error reporting is enabled. */
 	void setEnableErrorReporting( bool enable );
 	
+	/** Build uses of function bodies in parallel. */
+	inline bool getParallelFunctionBodies() const{ return pParallelFunctionBodies; }
+	
+	/**
+	 * Set if uses of function bodies are built in parallel. Function bodies are deferred
+	 * until the rest of the file is visited. Workers then resolve them concurrently using
+	 * only read locks. The collected uses and problems are committed under one write lock.
+	 */
+	void setParallelFunctionBodies( bool parallel );
+	
+	/**
+	 * Build uses of function \p node in place after DeclarationBuilder::buildFunction().
+	 * Uses outside the function contexts are left untouched.
+	 */
+	void buildFunction( const ReferencedTopDUContext &top, StartAst *start,
+		ClassBodyDeclarationAst *node );
+	
 	
 	
 protected:
+	void startVisiting( AstNode *node ) override;
+	void openContext( DUContext *newContext ) override;
+	void closeContext() override;
+	
 	void visitFullyQualifiedClassname( FullyQualifiedClassnameAst *node ) override;
 	void visitPin( PinAst *node ) override;
 	void visitNamespace( NamespaceAst *node ) override;
+	void visitClass( ClassAst *node ) override;
+	void visitClassFunctionDeclare( ClassFunctionDeclareAst *node ) override;
 	void visitClassFunctionDeclareBegin( ClassFunctionDeclareBeginAst *node ) override;
 	void visitClassVariablesDeclare( ClassVariablesDeclareAst *node ) override;
+	void visitInterface( InterfaceAst *node ) override;
+	void visitInterfaceFunctionDeclare( InterfaceFunctionDeclareAst *node ) override;
+	void visitEnumeration( EnumerationAst *node ) override;
 	void visitExpression( ExpressionAst *node ) override;
 	void visitExpressionConstant( ExpressionConstantAst *node ) override;
 	void visitExpressionMember( ExpressionMemberAst *node ) override;
@@ -66,14 +123,51 @@ protected:
 	void visitExpressionSpecial( ExpressionSpecialAst *node ) override;
 	void visitExpressionUnary( ExpressionUnaryAst *node ) override;
 	void visitExpressionInlineIfElse( ExpressionInlineIfElseAst *node ) override;
+	void visitStatementIf( StatementIfAst *node ) override;
+	void visitStatementElif( StatementElifAst *node ) override;
+	void visitStatementSelect( StatementSelectAst *node ) override;
+	void visitStatementCase( StatementCaseAst *node ) override;
 	void visitStatementFor( StatementForAst *node ) override;
+	void visitStatementWhile( StatementWhileAst *node ) override;
+	void visitStatementTry( StatementTryAst *node ) override;
+	void visitStatementCatch( StatementCatchAst *node ) override;
 	void visitStatementVariableDefinitions( StatementVariableDefinitionsAst *node ) override;
 	
 	/**
-	 * Get context at position or current content.
-	 * \note Internally locks DUChainReadLocker.
+	 * Open context the declaration builder set on node. Mirrors the contexts opened by
+	 * DeclarationBuilder so currentContext() is the context the visited node is located in.
+	 * Returns false if node has no context.
+	 */
+	bool openNodeContext( AstNode *node );
+	
+	/** Yield batch lock dropping cached look-ups if released. */
+	void yieldBatchLock();
+	
+	/** Visit statements inside the context opened on the first statement. */
+	void visitStatementSequence( const KDevPG::ListNode<StatementAst*> *sequence );
+	
+	/** Node the function context has been set on. */
+	static AstNode *functionContextNode( ClassFunctionDeclareAst *node );
+	
+	/** Collect use. */
+	void newUse( AstNode *node, const DeclarationPointer &declaration );
+	void newUse( const RangeInRevision &range, const DeclarationPointer &declaration );
+	
+	/**
+	 * Build uses of deferred function bodies in parallel. Returns the workers holding the
+	 * collected uses. Caller has to delete them.
+	 * \note Internally locks \em DUChainWriteLocker.
 	 */
-	DUContext *contextAtOrCurrent( const CursorInRevision &pos );
+	QVector<FunctionBodyWorker*> buildFunctionBodies();
+	
+	/**
+	 * Replace uses of collected contexts with collected uses and add collected problems.
+	 * \note Internally locks \em DUChainWriteLocker.
+	 */
+	void commitCollected( const QVector<FunctionBodyWorker*> &workers );
+	
+	/** Build uses of deferred function body collecting them. */
+	void buildFunctionBody( const FunctionBody &body );
 	
 	/**
 	 * Find context for function call object.
@@ -96,24 +190,18 @@ protected:
 	 */
 	void checkFunctionCall( AstNode *node, DUContext *context, const QVector<AbstractType::Ptr> &signature );
 	
-	/**
-	 * Report semantic error if reporting is enabled.
-	 * \note Internally locks \em DUChainWriteLocker.
-	 */
+	/** Report semantic error if reporting is enabled. */
 	void reportSemanticError( const RangeInRevision &range, const QString &hint );
 	
-	/**
-	 * Report semantic error if reporting is enabled.
-	 * \note Internally locks \em DUChainWriteLocker.
-	 */
+	/** Report semantic error if reporting is enabled. */
 	void reportSemanticError( const RangeInRevision &range, const QString &hint,
 		const QVector<IProblem::Ptr> &diagnostics );
 	
-	/**
-	 * Report semantic hint if reporting is enabled.
-	 * \note Internally locks \em DUChainWriteLocker.
-	 */
+	/** Report semantic hint if reporting is enabled. */
 	void reportSemanticHint( const RangeInRevision &range, const QString &hint );
+	
+	/** Collect problem. */
+	void addProblem( Problem *problem );
 };
 
 }
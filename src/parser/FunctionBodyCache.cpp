@@ -0,0 +1,196 @@
+#include <QMutexLocker>
+
+#include "FunctionBodyCache.h"
+#include "dsp_ast.h"
+#include "dsp_defaultvisitor.h"
+#include "dsp_tokenstream.h"
+
+
+namespace DragonScript{
+
+/** Visitor collecting function bodies. Function bodies are not visited. */
+class FunctionBodyCollector : public DefaultVisitor{
+public:
+	FunctionBodyCollector( const ParseSession &session, QVector<FunctionBodyCache::Body> &bodies ) :
+	pContents( session.contents() ),
+	pTokenStream( *session.tokenStream() ),
+	pBodies( bodies ),
+	pDeclaration( nullptr ){
+	}
+	
+	void visitClassBodyDeclaration( ClassBodyDeclarationAst *node ) override{
+		pDeclaration = node;
+		DefaultVisitor::visitClassBodyDeclaration( node );
+	}
+	
+	void visitClassFunctionDeclare( ClassFunctionDeclareAst *node ) override{
+		if( ! node->end || ! pDeclaration || pDeclaration->function != node ){
+			return;
+		}
+		
+		const Token &tokenBegin = pTokenStream.at( node->begin->endToken );
+		const Token &tokenEnd = pTokenStream.at( node->end->startToken );
+		
+		FunctionBodyCache::Body body;
+		body.declaration = pDeclaration;
+		body.begin = pContents.indexOf( '\n', tokenBegin.begin ) + 1;
+		body.end = pContents.lastIndexOf( '\n', tokenEnd.begin - 1 ) + 1;
+		body.beginLine = pTokenStream.at( pDeclaration->startToken ).line;
+		body.endLine = tokenEnd.line;
+		
+		// functions declared on a single line have no body lines
+		if( body.begin > 0 && body.end >= body.begin ){
+			pBodies << body;
+		}
+	}
+	
+private:
+	const QByteArray &pContents;
+	const TokenStream &pTokenStream;
+	QVector<FunctionBodyCache::Body> &pBodies;
+	ClassBodyDeclarationAst *pDeclaration;
+};
+
+
+
+// global instance
+FunctionBodyCache FunctionBodyCache::pSelf;
+
+
+FunctionBodyCache &FunctionBodyCache::self(){
+	return pSelf;
+}
+
+FunctionBodyCache::FunctionBodyCache() :
+pContentSize( 0 ),
+pMaxContentSize( 8 * 1024 * 1024 ){
+}
+
+QVector<FunctionBodyCache::Body> FunctionBodyCache::collect( const ParseSession &session, StartAst *ast ){
+	QVector<Body> bodies;
+	if( ast && session.tokenStream() ){
+		FunctionBodyCollector( session, bodies ).visitStart( ast );
+	}
+	return bodies;
+}
+
+int FunctionBodyCache::editedBody( const IndexedString &document, const ModificationRevision &revision,
+const QByteArray &contents, const QVector<Body> &bodies ){
+	QMutexLocker locker( &pMutex );
+	
+	if( ! pEntries.contains( document ) ){
+		return -1;
+	}
+	
+	const Entry &entry = pEntries[ document ];
+	if( ! ( entry.revision == revision ) || entry.bodies.size() != bodies.size() ){
+		return -1;
+	}
+	
+	// find changed range. outside this range old and new content are identical
+	const QByteArray &oldContents = entry.contents;
+	const int oldSize = oldContents.size();
+	const int newSize = contents.size();
+	const int commonSize = qMin( oldSize, newSize );
+	
+	int prefix = 0;
+	while( prefix < commonSize && oldContents.at( prefix ) == contents.at( prefix ) ){
+		prefix++;
+	}
+	
+	int suffix = 0;
+	while( suffix < commonSize - prefix
+	&& oldContents.at( oldSize - 1 - suffix ) == contents.at( newSize - 1 - suffix ) ){
+		suffix++;
+	}
+	
+	if( prefix == oldSize && prefix == newSize ){
+		return -1;
+	}
+	
+	// added or removed lines move all following declarations
+	const int oldEnd = oldSize - suffix;
+	const int newEnd = newSize - suffix;
+	if( oldContents.mid( prefix, oldEnd - prefix ).count( '\n' )
+	!= contents.mid( prefix, newEnd - prefix ).count( '\n' ) ){
+		return -1;
+	}
+	
+	// all functions have to be located on the same lines. the edited body has to contain
+	// the entire changed range
+	int index = -1;
+	int i;
+	
+	for( i=0; i<bodies.size(); i++ ){
+		const Body &oldBody = entry.bodies.at( i );
+		const Body &newBody = bodies.at( i );
+		
+		if( oldBody.beginLine != newBody.beginLine || oldBody.endLine != newBody.endLine ){
+			return -1;
+		}
+		
+		if( prefix >= oldBody.begin && prefix < oldBody.end && oldEnd <= oldBody.end ){
+			index = i;
+		}
+	}
+	
+	if( index == -1 ){
+		return -1;
+	}
+	
+	const Body &oldBody = entry.bodies.at( index );
+	const Body &newBody = bodies.at( index );
+	if( newBody.begin != oldBody.begin || newBody.end != oldBody.end + newSize - oldSize ){
+		return -1;
+	}
+	
+	return index;
+}
+
+void FunctionBodyCache::store( const IndexedString &document, const ModificationRevision &revision,
+const QByteArray &contents, const QVector<Body> &bodies ){
+	Entry entry{ revision, contents, bodies };
+	
+	// declarations point into the session which is going to be deleted
+	int i;
+	for( i=0; i<entry.bodies.size(); i++ ){
+		entry.bodies[ i ].declaration = nullptr;
+	}
+	
+	QMutexLocker locker( &pMutex );
+	removeInternal( document );
+	
+	pEntries.insert( document, entry );
+	pOrder.append( document );
+	pContentSize += contents.size();
+	
+	while( pContentSize > pMaxContentSize && pOrder.size() > 1 ){
+		const IndexedString oldest( pOrder.first() );
+		removeInternal( oldest );
+	}
+}
+
+void FunctionBodyCache::remove( const IndexedString &document ){
+	QMutexLocker locker( &pMutex );
+	removeInternal( document );
+}
+
+void FunctionBodyCache::clear(){
+	QMutexLocker locker( &pMutex );
+	pEntries.clear();
+	pOrder.clear();
+	pContentSize = 0;
+}
+
+void FunctionBodyCache::removeInternal( const IndexedString &document ){
+	QHash<IndexedString, Entry>::iterator iter( pEntries.find( document ) );
+	if( iter == pEntries.end() ){
+		return;
+	}
+	
+	pContentSize -= iter->contents.size();
+	pEntries.erase( iter );
+	pOrder.removeOne( document );
+}
+
+}
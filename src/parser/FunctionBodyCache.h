@@ -0,0 +1,110 @@
+#ifndef _FUNCTIONBODYCACHE_H_
+#define _FUNCTIONBODYCACHE_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+
+#include <language/duchain/modificationrevision.h>
+#include <serialization/indexedstring.h>
+
+#include "ParseSession.h"
+#include "parserexport.h"
+
+using KDevelop::IndexedString;
+using KDevelop::ModificationRevision;
+
+namespace DragonScript{
+
+struct ClassBodyDeclarationAst;
+
+/**
+ * Cache of function body locations of the last fully built content of documents.
+ *
+ * Typing inside a function body does not change anything outside the function. If the
+ * edit is located inside a single function body and does not add or remove lines the
+ * rest of the document keeps the same positions. Only this function has to be built
+ * again instead of running all phases across the entire document.
+ *
+ * Bodies are located by byte offsets. A body starts at the line following the function
+ * declaration and ends at the start of the line containing the function end. Edits
+ * touching the declaration or end line are not considered to be inside the body.
+ *
+ * The cache is bounded by the total size of the cached contents. If the limit is
+ * exceeded the oldest entries are dropped.
+ *
+ * This class works as singleton and is thread safe.
+ */
+class KDEVDSPARSER_EXPORT FunctionBodyCache{
+public:
+	/** Function body. */
+	struct Body{
+		/** Declaration of function. Only valid for the session the body is collected from. */
+		ClassBodyDeclarationAst *declaration;
+		
+		/** Byte offset of the first body line. */
+		int begin;
+		
+		/** Byte offset of the line containing the function end. */
+		int end;
+		
+		/** Line of the function declaration. */
+		int beginLine;
+		
+		/** Line of the function end. */
+		int endLine;
+	};
+	
+	
+	
+	/** Singleton instance. */
+	static FunctionBodyCache &self();
+	
+	/** Collect function bodies with end from parsed session. */
+	static QVector<Body> collect( const ParseSession &session, StartAst *ast );
+	
+	/**
+	 * Index of the body in \em bodies containing all changes between the cached content
+	 * and \em contents or -1. The cached content has to be the content of \em revision.
+	 * Returns -1 if lines have been added or removed or the bodies do not match.
+	 */
+	int editedBody( const IndexedString &document, const ModificationRevision &revision,
+		const QByteArray &contents, const QVector<Body> &bodies );
+	
+	/** Store bodies of content replacing the previous entry of document if present. */
+	void store( const IndexedString &document, const ModificationRevision &revision,
+		const QByteArray &contents, const QVector<Body> &bodies );
+	
+	/** Drop entry for document if present. */
+	void remove( const IndexedString &document );
+	
+	/** Drop all entries. */
+	void clear();
+	
+	
+	
+private:
+	struct Entry{
+		ModificationRevision revision;
+		QByteArray contents;
+		QVector<Body> bodies;
+	};
+	
+	FunctionBodyCache();
+	
+	void removeInternal( const IndexedString &document );
+	
+	static FunctionBodyCache pSelf;
+	
+	QMutex pMutex;
+	QHash<IndexedString, Entry> pEntries;
+	QList<IndexedString> pOrder;
+	int pContentSize;
+	const int pMaxContentSize;
+};
+
+}
+
+#endif
@@ -29,7 +29,11 @@ pCurrentDocument( filename ),
 pContents( contents ),
 pDebug( false ),
 pPool( new KDevPG::MemoryPool() ),
-pTokenStream( nullptr ){
+pTokenStream( nullptr ),
+pParsed( false ),
+pSkimmed( false ),
+pMatched( false ),
+pStartAst( nullptr ){
 }
 
 ParseSession::~ParseSession(){
@@ -47,7 +51,37 @@ TokenStream *ParseSession::tokenStream() const{
 	return pTokenStream;
 }
 
-bool ParseSession::parse( StartAst **ast ){
+qint64 ParseSession::memorySize() const{
+	qint64 size = pContents.size();
+	
+	// the memory pool allocates chained blocks growing in size. the AST lives in there
+	const KDevPG::BlockType *block = &pPool->blk;
+	while( block ){
+		size += block->blockSize;
+		block = block->chain;
+	}
+	
+	if( pTokenStream ){
+		size += pTokenStream->size() * ( qint64 )sizeof( Token );
+	}
+	
+	return size;
+}
+
+bool ParseSession::parse( StartAst **ast, bool skimFunctionBodies ){
+	if( pParsed && ( ! pSkimmed || skimFunctionBodies ) ){
+		*ast = pStartAst;
+		return pMatched;
+	}
+	
+	if( pParsed ){
+		// skimmed result lacks function bodies. drop it and parse again
+		delete pPool;
+		pPool = new KDevPG::MemoryPool();
+		pProblems.clear();
+		pStartAst = nullptr;
+	}
+	
 	if( pTokenStream ){
 		delete pTokenStream;
 		pTokenStream = nullptr;
@@ -59,6 +93,7 @@ bool ParseSession::parse( StartAst **ast ){
 	parser.setTokenStream( pTokenStream );
 	parser.setMemoryPool( pPool );
 	parser.setDebug( pDebug );
+	parser.setSkimFunctionBodies( skimFunctionBodies );
 	parser.setCurrentDocument( pCurrentDocument );
 	parser.setTodoMarkers( ICore::self()->languageController()->completionSettings()->todoMarkerWords() );
 	
@@ -72,16 +107,21 @@ bool ParseSession::parse( StartAst **ast ){
 		}
 // 		DebugVisitor( pTokenStream, QString::fromLatin1( pContents ) ).visitStart( dspAst );
 // 		DebugAst( *pTokenStream, pContents ).visitStart( dspAst );
-		*ast = dspAst;
+		pStartAst = dspAst;
 		
 	}else{
-		*ast = nullptr;
+		pStartAst = nullptr;
 		if( pDebug ){
 			parser.expectedSymbol( AstNode::StartKind, QStringLiteral( "start" ) );
 			qDebug() << "KDevDScript: ParseSession::parse Couldn't parse content";
 		}
 	}
 	pProblems << parser.problems();
+	
+	pParsed = true;
+	pSkimmed = skimFunctionBodies;
+	pMatched = matched;
+	*ast = pStartAst;
 	return matched;
 }
 
@@ -2,6 +2,7 @@
 #define _PARSESESSION_H_
 
 #include <QtCore/QString>
+#include <QtCore/QSharedPointer>
 
 #include "dsp_parser.h"
 #include "parserexport.h"
@@ -22,6 +23,9 @@ typedef QPair<DUContextPointer, RangeInRevision> SimpleUse;
 
 class KDEVDSPARSER_EXPORT ParseSession{
 public:
+	/** Reference type. */
+	typedef QSharedPointer<ParseSession> Ref;
+	
 	ParseSession( const IndexedString &filename, const QByteArray &contents );
 	~ParseSession();
 	
@@ -31,7 +35,24 @@ public:
 	inline const IndexedString &currentDocument() const{ return pCurrentDocument; }
 	inline const QByteArray &contents() const{ return pContents; }
 	
-	bool parse( StartAst ** );
+	/**
+	 * Parse contents. If the session has been parsed already the stored result is
+	 * returned instead of tokenizing and parsing again.
+	 * 
+	 * If \em skimFunctionBodies is true function bodies are skipped without building
+	 * statements. Such a result is good enough for building class and member declarations.
+	 * If a skimmed session is parsed later on without skimming it is parsed again.
+	 */
+	bool parse( StartAst **ast, bool skimFunctionBodies = false );
+	
+	/** Session has been parsed. */
+	inline bool parsed() const{ return pParsed; }
+	
+	/** Session has been parsed skimming function bodies. */
+	inline bool skimmed() const{ return pSkimmed; }
+	
+	/** Memory used by contents, token stream and memory pool in bytes. */
+	qint64 memorySize() const;
 	
 	QString symbol( qint64 token ) const;
 	QString symbol( const AstNode &node ) const;
@@ -56,11 +77,15 @@ public:
 	
 private:
 	const IndexedString pCurrentDocument;
-	const QByteArray &pContents;
+	const QByteArray pContents;
 	bool pDebug;
 	KDevPG::MemoryPool* pPool;
 	TokenStream* pTokenStream;
 	QList<ProblemPointer> pProblems;
+	bool pParsed;
+	bool pSkimmed;
+	bool pMatched;
+	StartAst *pStartAst;
 };
 
 }
@@ -0,0 +1,85 @@
+#include <QMutexLocker>
+
+#include "ParseSessionCache.h"
+
+
+namespace DragonScript{
+
+ParseSessionCache::ParseSessionCache() :
+pMemorySize( 0 ),
+pMaxMemorySize( 64 * 1024 * 1024 ){
+}
+
+ParseSessionCache::~ParseSessionCache(){
+	clear();
+}
+
+ParseSession::Ref ParseSessionCache::session( const IndexedString &document,
+const ModificationRevision &revision, const QByteArray &contents ){
+	QMutexLocker locker( &pMutex );
+	
+	if( pEntries.contains( document ) ){
+		const Entry &entry = pEntries[ document ];
+		if( entry.revision == revision ){
+			return entry.session;
+		}
+		removeInternal( document );
+	}
+	
+	// the session is not parsed yet. the memory size is updated once parsed
+	const ParseSession::Ref session( new ParseSession( document, contents ) );
+	const qint64 memorySize = session->memorySize();
+	pEntries.insert( document, Entry{ revision, session, memorySize } );
+	pOrder.append( document );
+	pMemorySize += memorySize;
+	
+	dropOldest();
+	return session;
+}
+
+void ParseSessionCache::updateMemorySize( const IndexedString &document ){
+	QMutexLocker locker( &pMutex );
+	
+	const QHash<IndexedString, Entry>::iterator iter( pEntries.find( document ) );
+	if( iter == pEntries.end() ){
+		return;
+	}
+	
+	const qint64 memorySize = iter->session->memorySize();
+	pMemorySize += memorySize - iter->memorySize;
+	iter->memorySize = memorySize;
+	
+	dropOldest();
+}
+
+void ParseSessionCache::remove( const IndexedString &document ){
+	QMutexLocker locker( &pMutex );
+	removeInternal( document );
+}
+
+void ParseSessionCache::clear(){
+	QMutexLocker locker( &pMutex );
+	pEntries.clear();
+	pOrder.clear();
+	pMemorySize = 0;
+}
+
+void ParseSessionCache::removeInternal( const IndexedString &document ){
+	QHash<IndexedString, Entry>::iterator iter( pEntries.find( document ) );
+	if( iter == pEntries.end() ){
+		return;
+	}
+	
+	pMemorySize -= iter->memorySize;
+	pEntries.erase( iter );
+	pOrder.removeOne( document );
+}
+
+void ParseSessionCache::dropOldest(){
+	while( pMemorySize > pMaxMemorySize && pOrder.size() > 1 ){
+		const IndexedString oldest( pOrder.first() );
+		removeInternal( oldest );
+	}
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef _PARSESESSIONCACHE_H_
+#define _PARSESESSIONCACHE_H_
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+#include <language/duchain/modificationrevision.h>
+#include <serialization/indexedstring.h>
+
+#include "ParseSession.h"
+#include "parserexport.h"
+
+using KDevelop::IndexedString;
+using KDevelop::ModificationRevision;
+
+namespace DragonScript{
+
+/**
+ * Cache of parse sessions shared by the parse jobs of the different phases.
+ * 
+ * Parsing runs in up to 3 phases each rescheduling the document. Without caching every
+ * phase tokenizes and parses the document again. Sessions are stored per document and
+ * content revision and keep the token stream, memory pool and AST alive until the
+ * document finished the last phase it needs or the content changes.
+ * 
+ * The cache is bounded by the memory used by the cached sessions including token streams
+ * and memory pools. If the limit is exceeded the oldest sessions are dropped.
+ * 
+ * The cache is owned by DSLanguageSupport. This class is thread safe.
+ */
+class KDEVDSPARSER_EXPORT ParseSessionCache{
+public:
+	/** Create empty cache. */
+	ParseSessionCache();
+	
+	/** Clean up cache. */
+	~ParseSessionCache();
+	
+	
+	
+	/**
+	 * Get session for document. If a session exists for the same content revision it is
+	 * returned. Otherwise a new session is created and stored replacing the old one.
+	 */
+	ParseSession::Ref session( const IndexedString &document,
+		const ModificationRevision &revision, const QByteArray &contents );
+	
+	/**
+	 * Update memory used by session of document after it has been parsed. Drops the
+	 * oldest sessions if the limit is exceeded.
+	 */
+	void updateMemorySize( const IndexedString &document );
+	
+	/** Drop session for document if present. */
+	void remove( const IndexedString &document );
+	
+	/** Drop all sessions. */
+	void clear();
+	
+	
+	
+private:
+	struct Entry{
+		ModificationRevision revision;
+		ParseSession::Ref session;
+		qint64 memorySize;
+	};
+	
+	void removeInternal( const IndexedString &document );
+	void dropOldest();
+	
+	QMutex pMutex;
+	QHash<IndexedString, Entry> pEntries;
+	QList<IndexedString> pOrder;
+	qint64 pMemorySize;
+	const qint64 pMaxMemorySize;
+};
+
+}
+
+#endif
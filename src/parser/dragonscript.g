@@ -38,6 +38,7 @@
 %ast_extra_members
 [:
 	KDevelop::DUContext* ducontext;
+	int memoIndex;
 :]
 
 
@@ -60,6 +61,7 @@ void setContents( const QByteArray *contents );
 void tokenize();
 QString tokenText( qint64 begin, qint64 end );
 void setDebug( bool debug );
+void setSkimFunctionBodies( bool skim );
 void setCurrentDocument( KDevelop::IndexedString url );
 void setTodoMarkers( const QStringList &markers );
 void extractTodosFromComment( const QString &comment, qint64 offset );
@@ -74,11 +76,15 @@ void extractTodosFromComment( const QString &comment, qint64 offset );
 	QRegularExpression pTodoMarkers;
 	
 	int pLastTypeModifiers;
+	bool pSkimFunctionBodies;
+	
+	void skipFunctionBody();
 :]
 
 %parserclass (constructor)
 [:
 	pContents = nullptr;
+	pSkimFunctionBodies = false;
 :]
 
 
@@ -275,8 +281,10 @@ CLASS name=identifier
 -> classBodyDeclaration ;;
 
 FUNC begin=classFunctionDeclareBegin
-	-- for non-abstract functions only
-	[: if( ( pLastTypeModifiers & etmAbstract ) != etmAbstract ){ :]
+	-- for non-abstract functions only. in skim mode the body is skipped up to the
+	-- matching end leaving body empty
+	[: if( ( pLastTypeModifiers & etmAbstract ) != etmAbstract ){
+		if( pSkimFunctionBodies ){ skipFunctionBody(); } :]
 	#body=statement*
 	end=classFunctionEnd
 	[: } :]
@@ -828,6 +836,50 @@ void Parser::setCurrentDocument( KDevelop::IndexedString url ){
 	pCurrentDocument = url;
 }
 
+void Parser::setSkimFunctionBodies( bool skim ){
+	pSkimFunctionBodies = skim;
+}
+
+void Parser::skipFunctionBody(){
+	// skip tokens up to the end matching the function without building statements.
+	// statements with a body and blocks increase the depth while end decreases it.
+	// "if" opens a body only if it starts a statement. otherwise it is an inline if-else
+	int lastToken = Token_LINEBREAK;
+	int depth = 0;
+	
+	while( yytoken != Token_EOF ){
+		switch( yytoken ){
+		case Token_END:
+			if( depth == 0 ){
+				return;
+			}
+			depth--;
+			break;
+			
+		case Token_IF:
+			if( lastToken == Token_LINEBREAK || lastToken == Token_COMMAND_SEPARATOR
+			|| lastToken == Token_ELSE ){
+				depth++;
+			}
+			break;
+			
+		case Token_SELECT:
+		case Token_WHILE:
+		case Token_FOR:
+		case Token_TRY:
+		case Token_BLOCK:
+			depth++;
+			break;
+			
+		default:
+			break;
+		}
+		
+		lastToken = yytoken;
+		yylex();
+	}
+}
+
 }
 
 :]
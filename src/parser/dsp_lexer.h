@@ -4,7 +4,7 @@
 #include "dsp_tokentype.h"
 #include "dsp_tokenstream.h"
 
-#include <kdev-pg-char-sets.h>
+#include <QByteArray>
 
 #include "QDebug"
 
@@ -12,23 +12,26 @@ namespace DragonScript{
 
 class KDEVDSPARSER_EXPORT Lexer :
 public DragonScript::TokenStream,
-public KDevPG::QByteArrayIterator,
 public TokenTypeWrapper
 {
-public:
-	typedef KDevPG::QByteArrayIterator Iterator;
-	
 private:
 	void *pScanner;
 	int pPosition;
 	
+	const QByteArray pContents;
+	int pReadPosition;
+	
 public:
-	Lexer( Iterator iter );
+	/**
+	 * Create lexer. Contents is shared not copied. Flex reads from it in blocks of
+	 * up to YY_READ_BUF_SIZE bytes instead of one character per call.
+	 */
+	Lexer( const QByteArray &contents );
 	~Lexer();
 	DragonScript::Token& read();
 	
 	// for flex use only
-	int nextChar( char &character );
+	int fillBuffer( char *buffer, int maxSize );
 	void advancePosition( int amount );
 };
 